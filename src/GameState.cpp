@@ -22,22 +22,47 @@ GameStateManager::GameStateManager()
 
 GameStateManager::~GameStateManager()
 {
-  GameState* state = m_currentState;
-  while (state)
+  for (GameState* list : { m_currentState, m_freeStates })
   {
-    // first grab the next most prevState from the current prev state
-    GameState* newPrevState = state->m_prevState;
+    GameState* state = list;
+    while (state)
+    {
+      // first grab the next most prevState from the current prev state
+      GameState* newPrevState = state->m_prevState;
 
-    // free the memory of the prevState
-    delete state;
+      // free the memory of the prevState
+      delete state;
 
-    state = newPrevState;
+      state = newPrevState;
+    }
   }
 }
 
+GameState* GameStateManager::acquire()
+{
+  if (not m_freeStates) return new GameState{};
+
+  GameState* state = m_freeStates;
+  m_freeStates = state->m_prevState;
+
+  *state = GameState{};
+  return state;
+}
+
+void GameStateManager::release(GameState* state)
+{
+  state->m_prevState = m_freeStates;
+  m_freeStates = state;
+}
+
 void GameStateManager::update(const Move& move)
 {
-  m_currentState = m_currentState->update(move);
+  m_currentState = m_currentState->update(move, acquire());
+}
+
+void GameStateManager::updateNull()
+{
+  m_currentState = m_currentState->updateNull(acquire());
 }
 
 const Move* const GameStateManager::pop()
@@ -48,34 +73,26 @@ const Move* const GameStateManager::pop()
 
   m_currentState = m_currentState->m_prevState;
 
-  delete state;
+  release(state);
 
   return &m_currentState->m_move;
 }
 
 bool GameStateManager::loadFen(std::string_view fen)
 {
-  // Remove all current states
+  // Release all current states
   GameState* state = m_currentState;
   while (state)
   {
     // first grab the next most prevState from the current prev state
     GameState* newPrevState = state->m_prevState;
 
-    // free the memory of the prevState
-    delete state;
+    release(state);
 
     state = newPrevState;
   }
 
-  // TODO (haigh) Stop creating new game states, and allocating memory, the manager can allocate
-  // a large block of memory aligned to 64 byte boundaries when it starts up. Then, when we want a
-  // new game state we can get a 64 byte chunk of preallocated memory from the manager, and when we
-  // want to delete a state we can hand it back to the manager.
-  //
-  // The when a new state is requested, the manager can hand out the most resently released block
-  // which is more likely to still be cached in L1.
-  m_currentState = new GameState{};
+  m_currentState = acquire();
 
   auto startOfCastlingRights = fen.find_first_of(" ");
   auto startOfEpTarget = fen.find_first_of(" ", startOfCastlingRights + 1);
@@ -192,12 +209,11 @@ void GameState::toggleSideToMove()
   m_side = not m_side;
 }
 
-GameState* GameState::update(const Move &move)
+GameState* GameState::update(const Move &move, GameState* newState)
 {
   // Save the move in the current state
   m_move = move;
 
-  GameState* newState = new GameState{};
   newState->m_prevState = this;
   newState->m_side = not m_side;
 
@@ -245,4 +261,23 @@ GameState* GameState::update(const Move &move)
   return newState;
 }
 
+GameState* GameState::updateNull(GameState* newState)
+{
+  m_move = Move{};
+
+  newState->m_prevState = this;
+  newState->m_side = not m_side;
+
+  for (int i = 0; i < 4; ++i)
+  {
+    newState->m_castlingRights[i] = m_castlingRights[i];
+  }
+
+  newState->m_epSquare = NULL_SQUARE;
+  newState->m_moveClock = (not m_side) ? m_moveClock + 1 : m_moveClock;
+  newState->m_halfMoveClock = m_halfMoveClock + 1;
+
+  return newState;
+}
+
 } // namespace yak
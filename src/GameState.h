@@ -6,10 +6,19 @@
 
 #include "bitboard.h"
 #include "types.h"
+#include "zobrist.h"
 
 namespace yak {
 
 class GameState;
+
+/*!
+ * \brief The stack of game states of a board, one for each move made.
+ *
+ * States that are popped are kept on a free list and handed out again by later moves, most recently
+ * released first as it is the most likely to still be cached, so making and undoing moves only
+ * allocates when the line played is deeper than any before it.
+ */
 class GameStateManager
 {
 public:
@@ -29,10 +38,22 @@ public:
   void update(const Move& move);
   const Move* const pop();
 
+  /*!
+   * \brief Pass the move to the other side, keeping the castling rights and clearing the ep square.
+   * Undone by pop.
+   */
+  void updateNull();
+
   bool loadFen(std::string_view fen);
 
 private:
+  GameState* acquire();
+  void release(GameState* state);
+
   GameState* m_currentState;
+
+  // Released states, linked through m_prevState
+  GameState* m_freeStates{ nullptr };
 };
 
 class GameState
@@ -48,8 +69,10 @@ public:
   /*!
    * \brief Update the game state based on a given move.
    * \param[in] move - The move to be made.
+   * \param[out] newState - Filled with the state after the move, which is returned.
    */
-  GameState* update(const Move &move);
+  GameState* update(const Move &move, GameState* newState);
+  GameState* updateNull(GameState* newState);
   GameState* pop();
 
   inline GameState* getPrevState()
@@ -138,7 +161,30 @@ public:
 
   inline Bitboard epTarget() const
   {
-    return bitboard::createBitboard(m_epSquare);
+    // NULL_SQUARE is 64, which can't be shifted into a bitboard
+    return (m_epSquare == NULL_SQUARE) ? bitboard::EMPTY : bitboard::createBitboard(m_epSquare);
+  }
+
+  /*!
+   * \brief The castling rights as a 4 bit mask, bit 0 is black king side, then black queen side,
+   * white king side and white queen side.
+   */
+  inline int castlingRights() const
+  {
+    return m_castlingRights[0] | (m_castlingRights[1] << 1) | (m_castlingRights[2] << 2) | (m_castlingRights[3] << 3);
+  }
+
+  /*!
+   * \brief The Zobrist hash of the position, this is maintained by the Board.
+   */
+  inline zobrist::Key hash() const
+  {
+    return m_hash;
+  }
+
+  inline void setHash(zobrist::Key hash)
+  {
+    m_hash = hash;
   }
 
 private:
@@ -154,6 +200,8 @@ private:
 
   GameState* m_prevState = nullptr;  // 8 bytes
 
+  zobrist::Key m_hash{ 0 };
+
   // The move that was applied in order to get to the next state
   Move m_move;
   PieceColour m_colours[2] = {PieceColour::BLACK, PieceColour::WHITE};
@@ -0,0 +1,185 @@
+#include "LargeBuffer.h"
+
+#include <cstdint>
+#include <cstdlib>
+#include <fstream>
+#include <new>
+#include <string>
+#include <utility>
+
+#if defined(__linux__)
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+
+namespace yak::memory {
+
+namespace {
+
+constexpr auto roundUp(std::size_t value, std::size_t multiple) -> std::size_t
+{
+  return (value + multiple - 1) / multiple * multiple;
+}
+
+/*
+ * The active transparent huge page setting is the bracketed one, eg "always [madvise] never".
+ */
+auto transparentHugePageSetting() -> std::string
+{
+  std::ifstream setting{ "/sys/kernel/mm/transparent_hugepage/enabled" };
+  std::string line;
+
+  if (not std::getline(setting, line)) return {};
+
+  const auto open = line.find('[');
+  const auto close = line.find(']', open);
+  if (open == std::string::npos || close == std::string::npos) return {};
+
+  return line.substr(open + 1, close - open - 1);
+}
+
+auto detectHugePageSupport() -> HugePageSupport
+{
+#if defined(YAK_DISABLE_HUGE_PAGES)
+  return { false, "disabled at build time (YAK_HUGE_PAGES=OFF)" };
+#elif !defined(__linux__) || !defined(MADV_HUGEPAGE)
+  return { false, "not supported on this platform" };
+#else
+  if (const char* env = std::getenv("YAK_HUGE_PAGES"); env != nullptr && std::string_view{ env } == "0")
+  {
+    return { false, "disabled by the YAK_HUGE_PAGES environment variable" };
+  }
+
+  const auto setting = transparentHugePageSetting();
+
+  if (setting == "always") return { true, "transparent huge pages (always)" };
+  if (setting == "madvise") return { true, "transparent huge pages (madvise)" };
+  if (setting == "never") return { false, "transparent huge pages are disabled by the kernel" };
+
+  return { false, "transparent huge pages are not available" };
+#endif
+}
+
+#if defined(__linux__) && defined(MADV_HUGEPAGE)
+
+/*
+ * Map a block aligned to a huge page boundary and advise the kernel to back it with huge pages.
+ *
+ * The mapping is rounded up to normal pages rather than huge pages, so a partial huge page at the
+ * end of the block is backed with normal pages instead of wasting the rest of a huge page.
+ */
+auto mapHugePages(std::size_t bytes, std::size_t& mappedSize) -> void*
+{
+  const auto pageSize = static_cast<std::size_t>(::sysconf(_SC_PAGESIZE));
+  const auto size = roundUp(bytes, pageSize);
+  const auto reserved = size + HUGE_PAGE_SIZE;
+
+  void* mapping = ::mmap(nullptr, reserved, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+  if (mapping == MAP_FAILED) return nullptr;
+
+  // Trim the mapping to the aligned block.
+  const auto address = reinterpret_cast<std::uintptr_t>(mapping);
+  const auto aligned = roundUp(address, HUGE_PAGE_SIZE);
+  const auto head = aligned - address;
+  const auto tail = reserved - head - size;
+
+  if (head) ::munmap(mapping, head);
+  if (tail) ::munmap(reinterpret_cast<void*>(aligned + size), tail);
+
+  void* block = reinterpret_cast<void*>(aligned);
+
+  if (::madvise(block, size, MADV_HUGEPAGE) != 0)
+  {
+    ::munmap(block, size);
+    return nullptr;
+  }
+
+  mappedSize = size;
+  return block;
+}
+
+#endif
+
+} // namespace
+
+auto toString(PageMode mode) -> std::string_view
+{
+  switch (mode)
+  {
+    case PageMode::HUGE_PAGES: return "huge pages";
+    case PageMode::NORMAL_PAGES: return "normal pages";
+  }
+
+  return "unknown";
+}
+
+auto hugePageSupport() -> HugePageSupport
+{
+  static const HugePageSupport support = detectHugePageSupport();
+  return support;
+}
+
+LargeBuffer::LargeBuffer(std::size_t bytes)
+  : m_size(bytes)
+{
+#if defined(__linux__) && defined(MADV_HUGEPAGE)
+  if (bytes >= HUGE_PAGE_SIZE && hugePageSupport().enabled)
+  {
+    m_data = mapHugePages(bytes, m_mappedSize);
+    if (m_data)
+    {
+      m_pageMode = PageMode::HUGE_PAGES;
+      return;
+    }
+  }
+#endif
+
+  m_data = std::aligned_alloc(CACHE_LINE_SIZE, roundUp(bytes, CACHE_LINE_SIZE));
+  if (m_data == nullptr) throw std::bad_alloc();
+}
+
+LargeBuffer::~LargeBuffer()
+{
+  release();
+}
+
+LargeBuffer::LargeBuffer(LargeBuffer&& other) noexcept
+  : m_data(std::exchange(other.m_data, nullptr))
+  , m_size(std::exchange(other.m_size, 0))
+  , m_mappedSize(std::exchange(other.m_mappedSize, 0))
+  , m_pageMode(std::exchange(other.m_pageMode, PageMode::NORMAL_PAGES))
+{
+}
+
+LargeBuffer& LargeBuffer::operator=(LargeBuffer&& other) noexcept
+{
+  if (this != &other)
+  {
+    release();
+    m_data = std::exchange(other.m_data, nullptr);
+    m_size = std::exchange(other.m_size, 0);
+    m_mappedSize = std::exchange(other.m_mappedSize, 0);
+    m_pageMode = std::exchange(other.m_pageMode, PageMode::NORMAL_PAGES);
+  }
+
+  return *this;
+}
+
+void LargeBuffer::release()
+{
+  if (m_data == nullptr) return;
+
+#if defined(__linux__) && defined(MADV_HUGEPAGE)
+  if (m_mappedSize)
+  {
+    ::munmap(m_data, m_mappedSize);
+    m_data = nullptr;
+    return;
+  }
+#endif
+
+  std::free(m_data);
+  m_data = nullptr;
+}
+
+} // namespace yak::memory
@@ -0,0 +1,84 @@
+#ifndef YAK_LARGE_BUFFER_H_
+#define YAK_LARGE_BUFFER_H_
+
+#include <cstddef>
+#include <string_view>
+
+namespace yak::memory {
+
+static constexpr std::size_t CACHE_LINE_SIZE = 64;
+static constexpr std::size_t HUGE_PAGE_SIZE = 2 * 1024 * 1024;
+
+/*
+ * How the memory of a large allocation is backed.
+ *
+ * HUGE_PAGES   - aligned to a huge page boundary and advised as transparent huge pages, so the
+ *                kernel backs every whole 2 MB of it with a single TLB entry.
+ * NORMAL_PAGES - cache line aligned, backed by normal pages. Used for allocations smaller than a
+ *                huge page, and whenever huge pages are unavailable or disabled.
+ */
+enum class PageMode
+{
+  HUGE_PAGES,
+  NORMAL_PAGES,
+};
+
+auto toString(PageMode mode) -> std::string_view;
+
+struct HugePageSupport
+{
+  bool enabled{ false };
+  std::string_view reason;
+};
+
+/*
+ * Whether large allocations will ask for huge pages, and why (or why not).
+ *
+ * Huge pages are used when the kernel's transparent huge page setting is "always" or "madvise".
+ * They can be turned off with the YAK_HUGE_PAGES CMake option, or at runtime by setting the
+ * YAK_HUGE_PAGES environment variable to 0.
+ */
+auto hugePageSupport() -> HugePageSupport;
+
+/*
+ * An uninitialised, cache line aligned block of memory for a large, frequently accessed table.
+ *
+ * Blocks of at least HUGE_PAGE_SIZE are backed with transparent huge pages when they are supported,
+ * falling back to normal pages if they aren't, or if the kernel refuses the advice. The mode that
+ * was used is reported by pageMode().
+ */
+class LargeBuffer
+{
+public:
+  LargeBuffer() = default;
+  explicit LargeBuffer(std::size_t bytes);
+  ~LargeBuffer();
+
+  LargeBuffer(const LargeBuffer&) = delete;
+  LargeBuffer& operator=(const LargeBuffer&) = delete;
+
+  LargeBuffer(LargeBuffer&& other) noexcept;
+  LargeBuffer& operator=(LargeBuffer&& other) noexcept;
+
+  template<typename T>
+  auto as() const -> T*
+  {
+    return static_cast<T*>(m_data);
+  }
+
+  auto data() const -> void* { return m_data; }
+  auto size() const -> std::size_t { return m_size; }
+  auto pageMode() const -> PageMode { return m_pageMode; }
+
+private:
+  void release();
+
+  void* m_data{ nullptr };
+  std::size_t m_size{ 0 };
+  std::size_t m_mappedSize{ 0 };
+  PageMode m_pageMode{ PageMode::NORMAL_PAGES };
+};
+
+} // namespace yak::memory
+
+#endif // YAK_LARGE_BUFFER_H_
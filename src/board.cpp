@@ -1,5 +1,6 @@
 #include "board.h"
 
+#include <algorithm>
 #include <cstring>
 #include <ctype.h>
 #include <sstream>
@@ -71,7 +72,76 @@ bool Board::parseFen(std::string_view fen)
   // Make sure that every square on the last rank was accounted for
   if (squaresOnRank != 8) return false;
 
-  return m_state.loadFen(fen.substr(endOfPiecePlacement + 1));
+  if (not m_state.loadFen(fen.substr(endOfPiecePlacement + 1))) return false;
+
+  m_state->setHash(computeHash());
+  return true;
+}
+
+zobrist::Key Board::computeHash() const
+{
+  zobrist::Key hash{ 0 };
+
+  for (auto colour : { PieceColour::BLACK, PieceColour::WHITE })
+  {
+    for (int type = 0; type < 6; ++type)
+    {
+      Bitboard pieces = getPosition(colour, static_cast<PieceType>(type));
+      while (pieces)
+      {
+        hash ^= zobrist::piece(colour, static_cast<PieceType>(type), bitboard::popLS1B(pieces));
+      }
+    }
+  }
+
+  hash ^= zobrist::castling(m_state->castlingRights());
+  hash ^= zobrist::enPassant(m_state->epTargetSquare());
+  hash ^= zobrist::side(m_state->sideToMove());
+
+  return hash;
+}
+
+zobrist::Key Board::pieceHashDelta(const Move& move, PieceColour colour) const
+{
+  // Castling and en passant moves are described by the side to move and the to square, the squares
+  // of black's pieces are 56 above the corresponding white squares.
+  const int rankOffset = (colour == PieceColour::WHITE) ? 0 : 56;
+
+  auto shifted = [rankOffset](Square square) { return static_cast<Square>(square + rankOffset); };
+
+  if (isKingSideCastle(move))
+  {
+    return zobrist::piece(colour, PieceType::KING, shifted(E1)) ^ zobrist::piece(colour, PieceType::KING, shifted(G1))
+         ^ zobrist::piece(colour, PieceType::ROOK, shifted(H1)) ^ zobrist::piece(colour, PieceType::ROOK, shifted(F1));
+  }
+
+  if (isQueenSideCastle(move))
+  {
+    return zobrist::piece(colour, PieceType::KING, shifted(E1)) ^ zobrist::piece(colour, PieceType::KING, shifted(C1))
+         ^ zobrist::piece(colour, PieceType::ROOK, shifted(A1)) ^ zobrist::piece(colour, PieceType::ROOK, shifted(D1));
+  }
+
+  const PieceColour otherSide = piece::otherColour(colour);
+  const Square fromSquare = from(move);
+  const Square toSquare = to(move);
+
+  if (isEnPassant(move))
+  {
+    const Square captureSquare = static_cast<Square>((colour == PieceColour::WHITE) ? toSquare - 8 : toSquare + 8);
+
+    return zobrist::piece(colour, PieceType::PAWN, fromSquare) ^ zobrist::piece(colour, PieceType::PAWN, toSquare)
+         ^ zobrist::piece(otherSide, PieceType::PAWN, captureSquare);
+  }
+
+  zobrist::Key delta = zobrist::piece(colour, moved(move), fromSquare)
+                     ^ zobrist::piece(colour, isPromotion(move) ? promotion(move) : moved(move), toSquare);
+
+  if (isCapture(move))
+  {
+    delta ^= zobrist::piece(otherSide, captured(move), toSquare);
+  }
+
+  return delta;
 }
 
 Bitboard Board::get_position(PieceType type) const
@@ -132,7 +202,19 @@ PieceColour Board::sideToMove() const
   return m_state->sideToMove();
 }
 
+zobrist::Key Board::hash() const
+{
+  return m_state->hash();
+}
+
 std::vector<Move> Board::generateMoves()
+{
+  Move moves[MAX_MOVES];
+  const int count = generateMoves(moves);
+  return std::vector<Move>(moves, moves + count);
+}
+
+int Board::generateMoves(Move* moves)
 {
   m_psudeoLegalMovePointer = 0;
   Move enPassantMove;
@@ -176,26 +258,218 @@ std::vector<Move> Board::generateMoves()
   m_psudeoLegalMovePointer += generatePieceMoves<PieceType::QUEEN>(&m_psuedoLegalMoveListBuffer[m_psudeoLegalMovePointer],
                                                                    thisSide);
 
-  std::vector<Move> legal_moves;
-  legal_moves.reserve(m_psudeoLegalMovePointer);
+  int count{ 0 };
   for (int i = 0; i < m_psudeoLegalMovePointer; i++)
   {
     makeMove(m_psuedoLegalMoveListBuffer[i]);
     // TODO (haigh) not safe, check for null here
     if (!isCheck(m_state->getPrevState()->sideToMove()))
     {
-      legal_moves.push_back(m_psuedoLegalMoveListBuffer[i]);
+      moves[count++] = m_psuedoLegalMoveListBuffer[i];
     }
     undoMove();
   }
 
-  generateCastlingMoves(legal_moves);
+  count += generateCastlingMoves(&moves[count]);
+
+  return count;
+}
+
+MoveCounts Board::countLegalMoves() const
+{
+  if (m_state->sideToMove() == PieceColour::WHITE)
+  {
+    return countLegalMoves<PieceColour::WHITE, CountMode::ALL>(nullptr);
+  }
+
+  return countLegalMoves<PieceColour::BLACK, CountMode::ALL>(nullptr);
+}
+
+MoveCounts Board::countLegalMoves(Move* checkingMoves) const
+{
+  if (m_state->sideToMove() == PieceColour::WHITE)
+  {
+    return countLegalMoves<PieceColour::WHITE, CountMode::CHECKS>(checkingMoves);
+  }
+
+  return countLegalMoves<PieceColour::BLACK, CountMode::CHECKS>(checkingMoves);
+}
+
+bool Board::hasLegalMoves() const
+{
+  if (m_state->sideToMove() == PieceColour::WHITE)
+  {
+    return countLegalMoves<PieceColour::WHITE, CountMode::ANY>(nullptr).m_total > 0;
+  }
+
+  return countLegalMoves<PieceColour::BLACK, CountMode::ANY>(nullptr).m_total > 0;
+}
+
+bool Board::givesCheck(Move const& move) const
+{
+  if (m_state->sideToMove() == PieceColour::WHITE)
+  {
+    return givesCheck<PieceColour::WHITE>(move, checkInfo<PieceColour::WHITE>());
+  }
+
+  return givesCheck<PieceColour::BLACK>(move, checkInfo<PieceColour::BLACK>());
+}
+
+int Board::see(Move const& move) const
+{
+  if (isCastle(move)) return 0;
+
+  const Square target = to(move);
+  const Exchange exchange = startExchange(move);
+
+  Bitboard occupied_bb = exchange.m_occupied;
+  Bitboard attackers_bb = attackersTo(target, occupied_bb) & occupied_bb;
+
+  // gain[d] is what the side making capture d wins if the exchange stops after it
+  int gain[32]{ exchange.m_gain };
+  int victim = exchange.m_victim;
+  int depth{ 0 };
+
+  PieceColour side = m_state->sideNotToMove();
+  while (true)
+  {
+    const Bitboard side_bb = get_position(side);
+    const PieceType attacker = popLeastValuable(target, attackers_bb, occupied_bb, side_bb);
+    if (attacker == PieceType::NULL_PIECE) break;
+
+    // The king can't capture onto a square that is still defended
+    if (attacker == PieceType::KING && (attackers_bb & ~side_bb) != 0) break;
+
+    ++depth;
+    gain[depth] = victim - gain[depth - 1];
+
+    victim = SEE_VALUES[static_cast<int>(attacker)];
+    side = (side == PieceColour::WHITE) ? PieceColour::BLACK : PieceColour::WHITE;
+  }
+
+  // Each side stops the exchange as soon as carrying on would lose more
+  while (depth > 0)
+  {
+    gain[depth - 1] = -std::max(-gain[depth - 1], gain[depth]);
+    --depth;
+  }
 
-  return legal_moves;
+  return gain[0];
 }
 
-void Board::generateCastlingMoves(std::vector<Move>& moves) const
+bool Board::seeGe(Move const& move, int threshold) const
 {
+  if (isCastle(move)) return threshold <= 0;
+
+  const Square target = to(move);
+  const Exchange exchange = startExchange(move);
+
+  // What is won over the threshold if the opponent doesn't recapture, and then if they do and we
+  // don't carry on. If the first is short, or the second enough, the answer is already known.
+  int swap = exchange.m_gain - threshold;
+  if (swap < 0) return false;
+
+  swap = exchange.m_victim - swap;
+  if (swap <= 0) return true;
+
+  Bitboard occupied_bb = exchange.m_occupied;
+  Bitboard attackers_bb = attackersTo(target, occupied_bb) & occupied_bb;
+
+  // Whether the side to move comes out ahead if the exchange ends with the side to capture next
+  bool result{ true };
+
+  PieceColour side = m_state->sideToMove();
+  while (true)
+  {
+    side = (side == PieceColour::WHITE) ? PieceColour::BLACK : PieceColour::WHITE;
+
+    const Bitboard side_bb = get_position(side);
+    if ((attackers_bb & side_bb) == 0) break;
+
+    result = not result;
+
+    const PieceType attacker = popLeastValuable(target, attackers_bb, occupied_bb, side_bb);
+
+    // The king can only capture if the square is no longer defended
+    if (attacker == PieceType::KING) return ((attackers_bb & ~side_bb) != 0) ? not result : result;
+
+    swap = SEE_VALUES[static_cast<int>(attacker)] - swap;
+    if (swap < static_cast<int>(result)) break;
+  }
+
+  return result;
+}
+
+Board::Exchange Board::startExchange(Move const& move) const
+{
+  Exchange exchange{};
+  exchange.m_occupied = occupiedSquares() ^ bitboard::createBitboard(from(move));
+
+  if (isCapture(move))
+  {
+    exchange.m_gain = SEE_VALUES[static_cast<int>(captured(move))];
+  }
+
+  if (isEnPassant(move))
+  {
+    const Bitboard to_bb = bitboard::createBitboard(to(move));
+    exchange.m_occupied ^= (m_state->sideToMove() == PieceColour::WHITE)
+      ? pawns::pawnSinglePushSource<PieceColour::WHITE>(to_bb)
+      : pawns::pawnSinglePushSource<PieceColour::BLACK>(to_bb);
+  }
+
+  if (isPromotion(move))
+  {
+    exchange.m_gain += SEE_VALUES[static_cast<int>(promotion(move))] - SEE_VALUES[static_cast<int>(PieceType::PAWN)];
+    exchange.m_victim = SEE_VALUES[static_cast<int>(promotion(move))];
+  }
+  else
+  {
+    exchange.m_victim = SEE_VALUES[static_cast<int>(moved(move))];
+  }
+
+  return exchange;
+}
+
+Bitboard Board::attackersTo(Square square, Bitboard occupied_bb) const
+{
+  return attackersTo<PieceColour::WHITE>(square, occupied_bb) | attackersTo<PieceColour::BLACK>(square, occupied_bb);
+}
+
+PieceType Board::popLeastValuable(Square square, Bitboard& attackers_bb, Bitboard& occupied_bb, Bitboard side_bb) const
+{
+  const Bitboard queens_bb = get_position(PieceType::QUEEN);
+  const Bitboard diagonal_bb = get_position(PieceType::BISHOP) | queens_bb;
+  const Bitboard straight_bb = get_position(PieceType::ROOK) | queens_bb;
+
+  for (int i = 0; i <= static_cast<int>(PieceType::KING); ++i)
+  {
+    const auto type = static_cast<PieceType>(i);
+    const Bitboard candidates_bb = attackers_bb & side_bb & get_position(type);
+    if (candidates_bb == 0) continue;
+
+    occupied_bb ^= bitboard::createBitboard(bitboard::LS1B(candidates_bb));
+
+    // Moving the attacker off its line to the square can uncover a slider behind it
+    if (type == PieceType::PAWN || type == PieceType::BISHOP || type == PieceType::QUEEN)
+    {
+      attackers_bb |= magic::MagicBitboards<PieceType::BISHOP>(square, occupied_bb) & diagonal_bb;
+    }
+    if (type == PieceType::ROOK || type == PieceType::QUEEN)
+    {
+      attackers_bb |= magic::MagicBitboards<PieceType::ROOK>(square, occupied_bb) & straight_bb;
+    }
+
+    attackers_bb &= occupied_bb;
+    return type;
+  }
+
+  return PieceType::NULL_PIECE;
+}
+
+int Board::generateCastlingMoves(Move* moves) const
+{
+  int count{ 0 };
   const Bitboard squaresAttackedByEnemy = attacked_by(m_state->sideNotToMove());
   const Bitboard king = getPosition(m_state->sideToMove(), PieceType::KING);
 
@@ -204,7 +478,7 @@ void Board::generateCastlingMoves(std::vector<Move>& moves) const
     const Bitboard kingPath = bitboard::shift<Direction::EAST>(king) | bitboard::shift<Direction::EAST>(bitboard::shift<Direction::EAST>(king));
     if ((kingPath & occupiedSquares()) == 0 && (kingPath & squaresAttackedByEnemy) == 0)
     {
-      moves.push_back(makeKingsideCastle());
+      moves[count++] = makeKingsideCastle();
     }
   }
 
@@ -214,16 +488,26 @@ void Board::generateCastlingMoves(std::vector<Move>& moves) const
     const Bitboard rookPath = kingPath | bitboard::shift<Direction::WEST>(kingPath);
     if ((rookPath & occupiedSquares()) == 0 && (kingPath & squaresAttackedByEnemy) == 0)
     {
-      moves.push_back(makeQueensideCastle());
+      moves[count++] = makeQueensideCastle();
     }
 
   }
+
+  return count;
 }
 
 Board::MoveResult Board::makeMove(const Move &move)
 {
   MoveResult result{};
 
+  // Remove the castling rights and ep file of this state from the hash, those of the new state are
+  // added once it has been created. The delta of the pieces is taken before the pieces move.
+  zobrist::Key hash = m_state->hash()
+                    ^ pieceHashDelta(move, m_state->sideToMove())
+                    ^ zobrist::castling(m_state->castlingRights())
+                    ^ zobrist::enPassant(m_state->epTargetSquare())
+                    ^ zobrist::side(m_state->sideToMove());
+
   if (m_state->sideToMove() == PieceColour::WHITE)
   {
     result = processMove<PieceColour::WHITE>(move, false);
@@ -235,6 +519,11 @@ Board::MoveResult Board::makeMove(const Move &move)
 
   m_state.update(move);
 
+  hash ^= zobrist::castling(m_state->castlingRights())
+        ^ zobrist::enPassant(m_state->epTargetSquare())
+        ^ zobrist::side(m_state->sideToMove());
+  m_state->setHash(hash);
+
   return result;
 }
 
@@ -252,6 +541,24 @@ Board::MoveResult Board::undoMove()
   return processMove<PieceColour::BLACK>(*move, true);
 }
 
+void Board::makeNullMove()
+{
+  zobrist::Key hash = m_state->hash()
+                    ^ zobrist::enPassant(m_state->epTargetSquare())
+                    ^ zobrist::side(m_state->sideToMove());
+
+  m_state.updateNull();
+
+  hash ^= zobrist::enPassant(m_state->epTargetSquare())
+        ^ zobrist::side(m_state->sideToMove());
+  m_state->setHash(hash);
+}
+
+void Board::undoNullMove()
+{
+  m_state.pop();
+}
+
 bool Board::isCheck() const
 {
   Bitboard king = getPosition(m_state->sideToMove(), PieceType::KING);
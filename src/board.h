@@ -12,11 +12,37 @@
 #include "pawns.h"
 #include "types.h"
 #include "xray.hpp"
+#include "zobrist.h"
 
 #include <magic/MagicBitboards.hpp>
 
 namespace yak {
 
+/**
+ * \brief The number of legal moves of a position, by kind of move. Promotions count once for each
+ * piece that can be promoted to. Checks are only counted when the checking moves are asked for.
+ */
+struct MoveCounts
+{
+  int m_total{ 0 };
+  int m_captures{ 0 };
+  int m_ep{ 0 };
+  int m_castles{ 0 };
+  int m_promotions{ 0 };
+  int m_checks{ 0 };
+};
+
+/**
+ * \brief The most legal moves of any position.
+ */
+static constexpr int MAX_MOVES{ 256 };
+
+/**
+ * \brief The values of the pieces for static exchange evaluation, in pawns, indexed by PieceType.
+ * The king is worth more than everything else put together, as it can never be given up.
+ */
+static constexpr int SEE_VALUES[]{ 1, 3, 3, 5, 8, 1000 };
+
 class Board
 {
 public:
@@ -39,6 +65,12 @@ public:
 
   PieceColour sideToMove() const;
 
+  /**
+   * \brief The Zobrist hash of the current position, updated incrementally by makeMove and
+   * restored by undoMove.
+   */
+  zobrist::Key hash() const;
+
   enum class MoveResult
   {
     SUCCESS = 0,
@@ -50,9 +82,66 @@ public:
   std::string to_string() const;
 
   std::vector<Move> generateMoves();
+
+  /**
+   * \brief Generate the legal moves into moves (room for MAX_MOVES), and return how many there
+   * are. Unlike the vector overload nothing is allocated, as the moves made to test legality reuse
+   * the game states released by earlier moves.
+   */
+  int generateMoves(Move* moves);
+
+  /**
+   * \brief Count the legal moves of the side to move, without generating them.
+   *
+   * The legal targets of each piece are found with masks (check evasions, pins, squares attacked
+   * by the opponent) and counted with popcounts, which is much cheaper than generating the moves
+   * and testing each one for legality. Only en passant captures are tested individually.
+   */
+  MoveCounts countLegalMoves() const;
+
+  /**
+   * \brief Count the legal moves as above, and also the moves that give check, which are written
+   * to checkingMoves (room for MAX_MOVES).
+   */
+  MoveCounts countLegalMoves(Move* checkingMoves) const;
+
+  /**
+   * \brief Whether the side to move has any legal move, stopping at the first one found.
+   */
+  bool hasLegalMoves() const;
+
+  /**
+   * \brief Whether a legal move of the side to move checks the opponent, without making it.
+   */
+  bool givesCheck(Move const& move) const;
+
+  /**
+   * \brief The static exchange evaluation of a move of the side to move: the material it wins,
+   * in SEE_VALUES, once every capture that follows on its square has been made, each side
+   * capturing with its least valuable piece and stopping when it is better not to capture.
+   *
+   * The exchange is played out on bitboards without making any moves. Sliding pieces behind
+   * those that have captured are found by looking again along their lines, and pins are ignored.
+   * Castling is worth 0.
+   */
+  int see(Move const& move) const;
+
+  /**
+   * \brief Whether the static exchange evaluation of a move is at least threshold, which is
+   * cheaper than see as the exchange stops as soon as the answer is known.
+   */
+  bool seeGe(Move const& move, int threshold) const;
+
   MoveResult makeMove(Move const& move);
   MoveResult undoMove();
 
+  /**
+   * \brief Pass the move to the opponent without moving a piece, for null move pruning. The side
+   * to move must not be in check. Undone by undoNullMove, not undoMove.
+   */
+  void makeNullMove();
+  void undoNullMove();
+
   /**
    * \brief Check if the king of the current m_side to move is in check/
    * \return true if the king is in check, false otherwise.
@@ -151,7 +240,79 @@ private:
   template<PieceColour C>
   int generatePawnMoves(Move* moveList, Bitboard pawnPositions, Bitboard emptySquares) const;
 
-  void generateCastlingMoves(std::vector<Move>& moves) const;
+  /*!
+   * \brief What is needed to tell whether a move gives check: the squares from which each type of
+   * piece would attack the enemy king, and our pieces that would uncover an attack on it by moving.
+   */
+  struct CheckInfo
+  {
+    Bitboard m_checkSquares[6]{ 0, 0, 0, 0, 0, 0 };
+    Bitboard m_discoverers{ 0 };
+    Square m_king{ NULL_SQUARE };
+  };
+
+  template<PieceColour C>
+  CheckInfo checkInfo() const;
+
+  template<PieceColour C>
+  bool givesCheck(Move const& move, CheckInfo const& info) const;
+
+  enum class CountMode
+  {
+    ALL,    // Count every legal move
+    ANY,    // Stop as soon as a legal move has been found
+    CHECKS, // Count every legal move, and write the moves that give check to checkingMoves
+  };
+
+  template<PieceColour C, CountMode Mode>
+  MoveCounts countLegalMoves(Move* checkingMoves) const;
+
+  /*!
+   * \brief The pieces of one colour attacking a square.
+   * \tparam C - The colour of the attacking pieces.
+   * \param[in] square - The attacked square.
+   * \param[in] occupied_bb - The occupied squares, which block the sliding pieces.
+   */
+  template<PieceColour C>
+  Bitboard attackersTo(Square square, Bitboard occupied_bb) const;
+
+  /*!
+   * \brief The pieces of both colours attacking a square.
+   */
+  Bitboard attackersTo(Square square, Bitboard occupied_bb) const;
+
+  /*!
+   * \brief Where the exchange started by a move begins: the squares occupied once it has been
+   * made, and the value of the piece left on its target square for the opponent to capture.
+   */
+  struct Exchange
+  {
+    Bitboard m_occupied{ 0 };
+    int m_gain{ 0 };
+    int m_victim{ 0 };
+  };
+
+  Exchange startExchange(Move const& move) const;
+
+  /*!
+   * \brief The least valuable of the attackers, which is removed from occupied_bb, and the
+   * attackers updated with any slider found behind it. Returns its type, or NULL_PIECE if there
+   * are no attackers.
+   */
+  PieceType popLeastValuable(Square square, Bitboard& attackers_bb, Bitboard& occupied_bb, Bitboard side_bb) const;
+
+  int generateCastlingMoves(Move* moves) const;
+
+  /*!
+   * \brief Hash the position from scratch, used when a position is loaded.
+   */
+  zobrist::Key computeHash() const;
+
+  /*!
+   * \brief The change to the hash of the piece placement made by a move.
+   */
+  zobrist::Key pieceHashDelta(Move const& move, PieceColour colour) const;
+
   bool parseFen(std::string_view fen);
   std::string rankToFen(Rank rank) const;
   std::string rankToBoardFen(Rank rank) const;
@@ -473,6 +634,356 @@ int Board::generatePawnMoves(Move* moveList,
   return moveCounter;
 };
 
+template<PieceColour C>
+Bitboard Board::attackersTo(Square square, Bitboard occupied_bb) const
+{
+  const Bitboard square_bb = bitboard::createBitboard(square);
+  const Bitboard queen_bb = getPosition(C, PieceType::QUEEN);
+
+  return (pawns::pawnAttacks<OppositeColour<C>>(square_bb) & getPosition(C, PieceType::PAWN))
+    | (piece::KnightMap::attacks(square) & getPosition(C, PieceType::KNIGHT))
+    | (piece::KingMap::attacks(square) & getPosition(C, PieceType::KING))
+    | (magic::MagicBitboards<PieceType::BISHOP>(square, occupied_bb) & (getPosition(C, PieceType::BISHOP) | queen_bb))
+    | (magic::MagicBitboards<PieceType::ROOK>(square, occupied_bb) & (getPosition(C, PieceType::ROOK) | queen_bb));
+}
+
+template<PieceColour C>
+Board::CheckInfo Board::checkInfo() const
+{
+  constexpr PieceColour Them = OppositeColour<C>;
+
+  CheckInfo info{};
+
+  const Bitboard king_bb = getPosition(Them, PieceType::KING);
+  if (king_bb == 0) return info;
+
+  const Bitboard occupied_bb = occupiedSquares();
+  const Square king = bitboard::LS1B(king_bb);
+
+  const Bitboard diagonal_bb = magic::MagicBitboards<PieceType::BISHOP>(king, occupied_bb);
+  const Bitboard straight_bb = magic::MagicBitboards<PieceType::ROOK>(king, occupied_bb);
+
+  info.m_king = king;
+  info.m_checkSquares[static_cast<int>(PieceType::PAWN)] = pawns::pawnAttacks<Them>(king_bb);
+  info.m_checkSquares[static_cast<int>(PieceType::KNIGHT)] = piece::KnightMap::attacks(king);
+  info.m_checkSquares[static_cast<int>(PieceType::BISHOP)] = diagonal_bb;
+  info.m_checkSquares[static_cast<int>(PieceType::ROOK)] = straight_bb;
+  info.m_checkSquares[static_cast<int>(PieceType::QUEEN)] = diagonal_bb | straight_bb;
+
+  // Our pieces standing alone between the enemy king and one of our sliders. Mostly there are no
+  // sliders on a line through the king at all, which is cheap to rule out.
+  const Bitboard own_bb = get_position(C);
+  const Bitboard queen_bb = getPosition(C, PieceType::QUEEN);
+  const Bitboard rooks_bb = (getPosition(C, PieceType::ROOK) | queen_bb) & magic::MagicBitboards<PieceType::ROOK>(king, Bitboard{ 0 });
+  const Bitboard bishops_bb = (getPosition(C, PieceType::BISHOP) | queen_bb) & magic::MagicBitboards<PieceType::BISHOP>(king, Bitboard{ 0 });
+
+  if (rooks_bb) info.m_discoverers |= pinned<PieceType::ROOK>(rooks_bb, king, occupied_bb, own_bb);
+  if (bishops_bb) info.m_discoverers |= pinned<PieceType::BISHOP>(bishops_bb, king, occupied_bb, own_bb);
+
+  return info;
+}
+
+template<PieceColour C>
+bool Board::givesCheck(Move const& move, CheckInfo const& info) const
+{
+  if (info.m_king == NULL_SQUARE) return false;
+
+  const Bitboard enemyKing_bb = bitboard::createBitboard(info.m_king);
+  const Bitboard occupied_bb = occupiedSquares();
+
+  // Only the rook can give check when castling, from its square next to the king
+  if (isKingSideCastle(move))
+  {
+    const Bitboard after_bb = occupied_bb ^ bitboard::KingCastleSource<C> ^ bitboard::KingCastleTarget<PieceType::KING, C>
+      ^ bitboard::RookCastleSource<PieceType::KING, C> ^ bitboard::RookCastleTarget<PieceType::KING, C>;
+    const Square rook = bitboard::LS1B(bitboard::RookCastleTarget<PieceType::KING, C>);
+    return (magic::MagicBitboards<PieceType::ROOK>(rook, after_bb) & enemyKing_bb) != 0;
+  }
+
+  if (isQueenSideCastle(move))
+  {
+    const Bitboard after_bb = occupied_bb ^ bitboard::KingCastleSource<C> ^ bitboard::KingCastleTarget<PieceType::QUEEN, C>
+      ^ bitboard::RookCastleSource<PieceType::QUEEN, C> ^ bitboard::RookCastleTarget<PieceType::QUEEN, C>;
+    const Square rook = bitboard::LS1B(bitboard::RookCastleTarget<PieceType::QUEEN, C>);
+    return (magic::MagicBitboards<PieceType::ROOK>(rook, after_bb) & enemyKing_bb) != 0;
+  }
+
+  const Square fromSquare = from(move);
+  const Square toSquare = to(move);
+  const Bitboard from_bb = bitboard::createBitboard(fromSquare);
+  const Bitboard to_bb = bitboard::createBitboard(toSquare);
+
+  // En passant takes two pawns off the board, either of which may have been blocking a slider
+  if (isEnPassant(move))
+  {
+    const Bitboard after_bb = occupied_bb ^ from_bb ^ to_bb ^ pawns::pawnSinglePushSource<C>(to_bb);
+    const Bitboard queen_bb = getPosition(C, PieceType::QUEEN);
+
+    return (info.m_checkSquares[static_cast<int>(PieceType::PAWN)] & to_bb)
+      || (magic::MagicBitboards<PieceType::BISHOP>(info.m_king, after_bb) & (getPosition(C, PieceType::BISHOP) | queen_bb))
+      || (magic::MagicBitboards<PieceType::ROOK>(info.m_king, after_bb) & (getPosition(C, PieceType::ROOK) | queen_bb));
+  }
+
+  // Moving off the line through the enemy king uncovers the slider behind
+  if ((info.m_discoverers & from_bb) && (LineThrough::value[info.m_king][fromSquare] & to_bb) == 0) return true;
+
+  if (isPromotion(move))
+  {
+    // The promoted piece attacks through the square the pawn has just left
+    const Bitboard after_bb = (occupied_bb ^ from_bb) | to_bb;
+
+    switch (promotion(move))
+    {
+      case PieceType::KNIGHT: return (piece::KnightMap::attacks(toSquare) & enemyKing_bb) != 0;
+      case PieceType::BISHOP: return (magic::MagicBitboards<PieceType::BISHOP>(toSquare, after_bb) & enemyKing_bb) != 0;
+      case PieceType::ROOK: return (magic::MagicBitboards<PieceType::ROOK>(toSquare, after_bb) & enemyKing_bb) != 0;
+      case PieceType::QUEEN:
+        return ((magic::MagicBitboards<PieceType::BISHOP>(toSquare, after_bb) | magic::MagicBitboards<PieceType::ROOK>(toSquare, after_bb))
+                & enemyKing_bb) != 0;
+      default: return false;
+    }
+  }
+
+  // A slider can't attack the king through the square it left, as it would already be giving check
+  return (info.m_checkSquares[static_cast<int>(moved(move))] & to_bb) != 0;
+}
+
+template<PieceColour C, Board::CountMode Mode>
+MoveCounts Board::countLegalMoves(Move* checkingMoves) const
+{
+  constexpr PieceColour Them = OppositeColour<C>;
+
+  MoveCounts counts{};
+
+  const Bitboard own_bb = get_position(C);
+  const Bitboard enemy_bb = get_position(Them);
+  const Bitboard occupied_bb = own_bb | enemy_bb;
+  const Bitboard king_bb = getPosition(C, PieceType::KING);
+
+  // Shouldn't happen, but some tests run the board without a king
+  if (king_bb == 0) return counts;
+
+  const Square kingSquare = bitboard::LS1B(king_bb);
+
+  auto addTargets = [&counts, enemy_bb](Bitboard targets)
+  {
+    counts.m_total += bitboard::countSetBits(targets);
+    counts.m_captures += bitboard::countSetBits(targets & enemy_bb);
+  };
+
+  auto found = [&counts]
+  {
+    return Mode == CountMode::ANY && counts.m_total > 0;
+  };
+
+  // Checking moves are picked out of the targets with the squares that attack the enemy king, apart
+  // from the special moves, which are tested one by one.
+  constexpr bool Checks = (Mode == CountMode::CHECKS);
+  const CheckInfo info = Checks ? checkInfo<C>() : CheckInfo{};
+
+  auto addCheck = [&counts, checkingMoves](Move move)
+  {
+    checkingMoves[counts.m_checks++] = move;
+  };
+
+  auto addChecks = [&](Square from, PieceType type, Bitboard targets)
+  {
+    if constexpr (not Checks) return;
+
+    const Bitboard discovered_bb = (info.m_discoverers & bitboard::createBitboard(from)) ? ~LineThrough::value[info.m_king][from]
+                                                                                         : Bitboard{ 0 };
+    Bitboard checks_bb = targets & (info.m_checkSquares[static_cast<int>(type)] | discovered_bb);
+    while (checks_bb)
+    {
+      const Square to = bitboard::popLS1B(checks_bb);
+
+      if (enemy_bb & bitboard::createBitboard(to))
+      {
+        addCheck(makeCapture(from, to, type, getPieceTypeOn(to)));
+      }
+      else if (type == PieceType::PAWN && (to ^ from) == 16)
+      {
+        addCheck(makeDoublePush(from, to));
+      }
+      else
+      {
+        addCheck(makeQuiet(from, to, type));
+      }
+    }
+  };
+
+  // The king can't move to a square attacked by the opponent, including squares that are only
+  // attacked once the king is no longer blocking a slider.
+  const Bitboard withoutKing_bb = occupied_bb ^ king_bb;
+  const Bitboard enemyQueen_bb = getPosition(Them, PieceType::QUEEN);
+  const Bitboard danger_bb = pawns::pawnAttacks<Them>(getPosition(Them, PieceType::PAWN))
+    | piece::pieceAttacks<PieceType::KNIGHT>(getPosition(Them, PieceType::KNIGHT), withoutKing_bb)
+    | piece::pieceAttacks<PieceType::BISHOP>(getPosition(Them, PieceType::BISHOP) | enemyQueen_bb, withoutKing_bb)
+    | piece::pieceAttacks<PieceType::ROOK>(getPosition(Them, PieceType::ROOK) | enemyQueen_bb, withoutKing_bb)
+    | piece::pieceAttacks<PieceType::KING>(getPosition(Them, PieceType::KING), withoutKing_bb);
+
+  const Bitboard kingTargets_bb = piece::KingMap::attacks(kingSquare) & ~own_bb & ~danger_bb;
+  addTargets(kingTargets_bb);
+  addChecks(kingSquare, PieceType::KING, kingTargets_bb);
+  if (found()) return counts;
+
+  // In double check only the king can move
+  const Bitboard checkers_bb = attackersTo<Them>(kingSquare, occupied_bb);
+  if (bitboard::countSetBits(checkers_bb) > 1) return counts;
+
+  // In check, the other pieces must capture the checker or block the check
+  const Bitboard checkMask_bb = checkers_bb ? (InBetween::value[kingSquare][bitboard::LS1B(checkers_bb)] | checkers_bb)
+                                            : ~Bitboard{ 0 };
+  const Bitboard targetMask_bb = ~own_bb & checkMask_bb;
+
+  // Pinned pieces can only move along the line through the king and the pinning piece
+  const Bitboard pinned_bb = getPinned<C>();
+  auto pinMask = [pinned_bb, kingSquare](Square square) -> Bitboard
+  {
+    return (pinned_bb & bitboard::createBitboard(square)) ? LineThrough::value[kingSquare][square] : ~Bitboard{ 0 };
+  };
+
+  // A pinned knight can never move
+  Bitboard knight_bb = getPosition(C, PieceType::KNIGHT) & ~pinned_bb;
+  while (knight_bb)
+  {
+    const Square square = bitboard::popLS1B(knight_bb);
+    const Bitboard targets_bb = piece::KnightMap::attacks(square) & targetMask_bb;
+    addTargets(targets_bb);
+    addChecks(square, PieceType::KNIGHT, targets_bb);
+    if (found()) return counts;
+  }
+
+  const Bitboard queen_bb = getPosition(C, PieceType::QUEEN);
+
+  // Queens are visited twice, once for each direction, so look up their type for the checks
+  Bitboard diagonal_bb = getPosition(C, PieceType::BISHOP) | queen_bb;
+  while (diagonal_bb)
+  {
+    const Square square = bitboard::popLS1B(diagonal_bb);
+    const Bitboard targets_bb = magic::MagicBitboards<PieceType::BISHOP>(square, occupied_bb) & targetMask_bb & pinMask(square);
+    addTargets(targets_bb);
+    addChecks(square, (queen_bb & bitboard::createBitboard(square)) ? PieceType::QUEEN : PieceType::BISHOP, targets_bb);
+    if (found()) return counts;
+  }
+
+  Bitboard straight_bb = getPosition(C, PieceType::ROOK) | queen_bb;
+  while (straight_bb)
+  {
+    const Square square = bitboard::popLS1B(straight_bb);
+    const Bitboard targets_bb = magic::MagicBitboards<PieceType::ROOK>(square, occupied_bb) & targetMask_bb & pinMask(square);
+    addTargets(targets_bb);
+    addChecks(square, (queen_bb & bitboard::createBitboard(square)) ? PieceType::QUEEN : PieceType::ROOK, targets_bb);
+    if (found()) return counts;
+  }
+
+  const Bitboard pawn_bb = getPosition(C, PieceType::PAWN);
+  const Bitboard promotionRank_bb = (C == PieceColour::WHITE) ? bitboard::RANK_8 : bitboard::RANK_1;
+
+  Bitboard pawns_bb = pawn_bb;
+  while (pawns_bb)
+  {
+    const Square square = bitboard::popLS1B(pawns_bb);
+    const Bitboard square_bb = bitboard::createBitboard(square);
+
+    const Bitboard push_bb = pawns::pawnSinglePushTarget<C>(square_bb) & ~occupied_bb;
+    const Bitboard doublePush_bb = pawns::pawnSinglePushTarget<C>(push_bb) & ~occupied_bb & pawns::pawnDoublePushTarget<C>();
+    const Bitboard capture_bb = pawns::pawnAttacks<C>(square_bb) & enemy_bb;
+
+    const Bitboard targets_bb = (push_bb | doublePush_bb | capture_bb) & checkMask_bb & pinMask(square);
+
+    if (targets_bb & promotionRank_bb)
+    {
+      const int promotions = 4 * bitboard::countSetBits(targets_bb);
+      counts.m_total += promotions;
+      counts.m_captures += 4 * bitboard::countSetBits(targets_bb & enemy_bb);
+      counts.m_promotions += promotions;
+
+      Bitboard promotion_bb = Checks ? targets_bb : Bitboard{ 0 };
+      while (promotion_bb)
+      {
+        const Square to = bitboard::popLS1B(promotion_bb);
+        const bool capture = (enemy_bb & bitboard::createBitboard(to)) != 0;
+
+        for (auto type : { PieceType::KNIGHT, PieceType::BISHOP, PieceType::ROOK, PieceType::QUEEN })
+        {
+          const Move move = capture ? makeCapturePromotion(square, to, type, getPieceTypeOn(to))
+                                    : makeQuietPromotion(square, to, type);
+          if (givesCheck<C>(move, info)) addCheck(move);
+        }
+      }
+    }
+    else
+    {
+      addTargets(targets_bb);
+      addChecks(square, PieceType::PAWN, targets_bb);
+    }
+
+    if (found()) return counts;
+  }
+
+  // En passant captures remove two pieces from the line of a slider, so rather than use the masks,
+  // check whether the king is attacked once the capture has been made.
+  if (m_state->epTargetSquare() != NULL_SQUARE)
+  {
+    const Bitboard ep_bb = m_state->epTarget();
+    const Bitboard captured_bb = pawns::pawnSinglePushSource<C>(ep_bb);
+
+    Bitboard sources_bb = pawns::pawnAttacks<Them>(ep_bb) & pawn_bb;
+    while (sources_bb)
+    {
+      const Square source = bitboard::popLS1B(sources_bb);
+      const Bitboard after_bb = occupied_bb ^ bitboard::createBitboard(source) ^ ep_bb ^ captured_bb;
+
+      if ((attackersTo<Them>(kingSquare, after_bb) & ~captured_bb) == 0)
+      {
+        ++counts.m_total;
+        ++counts.m_captures;
+        ++counts.m_ep;
+
+        if constexpr (Checks)
+        {
+          const Move move = makeEpCapture(source, m_state->epTargetSquare());
+          if (givesCheck<C>(move, info)) addCheck(move);
+        }
+      }
+    }
+
+    if (found()) return counts;
+  }
+
+  // Castling, with the same conditions as generateCastlingMoves
+  if (checkers_bb == 0)
+  {
+    if (m_state->canKingSideCastle())
+    {
+      const Bitboard kingPath = bitboard::shift<Direction::EAST>(king_bb) | bitboard::shift<Direction::EAST>(bitboard::shift<Direction::EAST>(king_bb));
+      if ((kingPath & occupied_bb) == 0 && (kingPath & danger_bb) == 0)
+      {
+        ++counts.m_total;
+        ++counts.m_castles;
+
+        if (Checks && givesCheck<C>(makeKingsideCastle(), info)) addCheck(makeKingsideCastle());
+      }
+    }
+
+    if (m_state->canQueenSideCastle())
+    {
+      const Bitboard kingPath = bitboard::shift<Direction::WEST>(king_bb) | bitboard::shift<Direction::WEST>(bitboard::shift<Direction::WEST>(king_bb));
+      const Bitboard rookPath = kingPath | bitboard::shift<Direction::WEST>(kingPath);
+      if ((rookPath & occupied_bb) == 0 && (kingPath & danger_bb) == 0)
+      {
+        ++counts.m_total;
+        ++counts.m_castles;
+
+        if (Checks && givesCheck<C>(makeQueensideCastle(), info)) addCheck(makeQueensideCastle());
+      }
+    }
+  }
+
+  return counts;
+}
+
 template<PieceColour ToMove>
 Bitboard Board::getPinned() const
 {
@@ -1,98 +1,538 @@
 #include "AlphaBeta.h"
+#include "MovePicker.h"
+#include "Search.h"
+#include "TranspositionTable.h"
 
 #include <board.h>
-#include <limits>
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstdlib>
+#include <span>
 
 namespace yak::engine {
 
-std::pair<int, Move> alphaBeta(Board& board, int depth, PieceColour us)
+namespace {
+
+/*
+ * The table keeps mate scores as the distance to the mate from the position rather than from the
+ * root, as the position can be reached at other plies.
+ */
+auto scoreToTable(int score, int ply) -> int
+{
+  if (score >= MATE_BOUND) return score + ply;
+  if (score <= -MATE_BOUND) return score - ply;
+  return score;
+}
+
+auto scoreFromTable(int score, int ply) -> int
 {
-  return alphaBeta(board,
-                   std::numeric_limits<int>::min(),
-                   std::numeric_limits<int>::max(),
-                   depth,
-                   (board.sideToMove() == us));
+  if (score >= MATE_BOUND) return score - ply;
+  if (score <= -MATE_BOUND) return score + ply;
+  return score;
 }
 
-std::pair<int, Move> alphaBeta(Board& board, int alpha, int beta, int depth, bool maximise)
+/*
+ * Store the result of a search of the position at ply in the table, and return its score.
+ */
+auto store(SearchContext& context, zobrist::Key key, int depth, int ply, int alpha, int beta, int score, Move move) -> int
 {
-  if (depth == 0)
+  // The results of a stopped search are meaningless
+  TranspositionTable* table = context.table();
+  if (table && not context.stopped())
   {
-    return { evaluate(board), {} };
+    const Bound bound = (score <= alpha) ? Bound::UPPER : (score >= beta) ? Bound::LOWER : Bound::EXACT;
+    table->store(key, depth, scoreToTable(score, ply), bound, move);
   }
 
-  Move bestMove;
+  return score;
+}
+
+/*
+ * The static evaluation from the point of view of the side to move.
+ */
+auto staticEvaluation(Board& board) -> int
+{
+  const int score = evaluate(board);
+  return (board.sideToMove() == PieceColour::WHITE) ? score : -score;
+}
+
+// A capture that can't raise the score to within this of alpha, even winning the captured piece
+// and the squares it attacks for nothing, is not searched by quiescence. Allows for the change in
+// the rest of the evaluation.
+static constexpr int DELTA_MARGIN{ 3 };
 
-  if (maximise)
+/*
+ * The most a capture can gain, by the terms of evaluate: the value of the captured piece, and the
+ * squares it attacked, which its side may no longer attack.
+ */
+auto captureGain(const Board& board, Move move) -> int
+{
+  const PieceType type = captured(move);
+  const Square square = to(move);
+  const Bitboard occupied = board.occupiedSquares();
+
+  Bitboard attacks{ 0 };
+  switch (type)
   {
-    int maxEvaluation = std::numeric_limits<int>::min();
+    case PieceType::PAWN: return pieceValue(type) + 2;
+    case PieceType::KNIGHT: attacks = piece::KnightMap::attacks(square); break;
+    case PieceType::BISHOP: attacks = magic::MagicBitboards<PieceType::BISHOP>(square, occupied); break;
+    case PieceType::ROOK: attacks = magic::MagicBitboards<PieceType::ROOK>(square, occupied); break;
+    case PieceType::QUEEN:
+      attacks = magic::MagicBitboards<PieceType::BISHOP>(square, occupied) | magic::MagicBitboards<PieceType::ROOK>(square, occupied);
+      break;
+    default: break;
+  }
 
-    for (const auto& move : board.generateMoves())
+  return pieceValue(type) + bitboard::countSetBits(attacks);
+}
+
+/*
+ * Search captures and promotions at the horizon until the position is quiet, so that leaves aren't
+ * scored in the middle of an exchange. The side to move can stand pat, taking the static
+ * evaluation, rather than make a bad capture. In check there is no standing pat, and every evasion
+ * is searched.
+ */
+auto quiescence(Board& board, int alpha, int beta, int ply, SearchContext& context) -> int
+{
+  if (context.visit())
+  {
+    return 0;
+  }
+
+  // The line from here is never part of the principal variation
+  PlyState& state = context.stack()[ply];
+  state.m_pvLength = 0;
+
+  if (ply >= MAX_PLY - 1)
+  {
+    return staticEvaluation(board);
+  }
+
+  const bool inCheck = board.isCheck();
+
+  state.m_moveCount = board.generateMoves(state.m_moves.data());
+  if (state.m_moveCount == 0)
+  {
+    return inCheck ? matedIn(ply) : DRAW_SCORE;
+  }
+
+  int bestScore = -INFINITE_SCORE;
+  int standPat{ 0 };
+
+  if (not inCheck)
+  {
+    standPat = staticEvaluation(board);
+    state.m_staticEval = standPat;
+
+    if (standPat >= beta)
+    {
+      return standPat;
+    }
+
+    alpha = std::max(alpha, standPat);
+    bestScore = standPat;
+
+    const auto moves = state.moves();
+    state.m_moveCount = std::remove_if(moves.begin(), moves.end(), isQuiet) - moves.begin();
+  }
+  else
+  {
+    state.m_staticEval = -INFINITE_SCORE;
+  }
+
+  const bool deltaPruning = context.options().m_deltaPruning && not inCheck;
+  const bool seePruning = context.options().m_seePruning && not inCheck;
+
+  MovePicker picker{ board, state.moves(), 0 };
+  Move move;
+
+  while (picker.next(move))
+  {
+    if (deltaPruning && not isPromotion(move) && standPat + captureGain(board, move) + DELTA_MARGIN <= alpha)
     {
-      board.makeMove(move);
+      continue;
+    }
 
-      if (board.isCheckmate())
+    if (seePruning && not board.seeGe(move, 0))
+    {
+      continue;
+    }
+
+    state.m_currentMove = move;
+
+    board.makeMove(move);
+    const int score = -quiescence(board, -beta, -alpha, ply + 1, context);
+    board.undoMove();
+
+    if (context.stopped())
+    {
+      return 0;
+    }
+
+    if (score > bestScore)
+    {
+      bestScore = score;
+
+      if (score > alpha)
       {
-        board.undoMove();
-        return { std::numeric_limits<int>::max(), move };
+        alpha = score;
       }
+    }
+
+    if (alpha >= beta)
+    {
+      break;
+    }
+  }
+
+  return bestScore;
+}
+
+// Null move pruning searches the reply to passing NULL_MOVE_REDUCTION plies shallower, and one
+// more for every NULL_MOVE_DEPTH_DIVISOR plies of depth
+static constexpr int NULL_MOVE_DEPTH{ 3 };
+static constexpr int NULL_MOVE_REDUCTION{ 3 };
+static constexpr int NULL_MOVE_DEPTH_DIVISOR{ 6 };
+
+// With less than a rook besides pawns, passing is often the best move there is, so a null move
+// cutoff is only trusted once a search without it agrees
+static constexpr int ZUGZWANG_MATERIAL{ 5 };
+
+// Near the leaves, a position whose static evaluation is this far per ply above beta is assumed to
+// hold (reverse futility), and one this far per ply below alpha is only searched for captures and
+// checks (futility), or by quiescence (razoring)
+static constexpr int REVERSE_FUTILITY_DEPTH{ 3 };
+static constexpr int REVERSE_FUTILITY_MARGIN{ 3 };
+static constexpr int FUTILITY_DEPTH{ 3 };
+static constexpr int FUTILITY_MARGIN{ 4 };
+static constexpr int RAZORING_DEPTH{ 2 };
+static constexpr int RAZORING_MARGIN{ 5 };
 
-      auto [evaluation, _] = alphaBeta(board, alpha, beta, depth - 1, false);
-      board.undoMove();
+// Late move reductions start with the LMR_MOVES'th move at LMR_DEPTH
+static constexpr int LMR_DEPTH{ 3 };
+static constexpr size_t LMR_MOVES{ 3 };
 
-      if (evaluation > maxEvaluation)
+/*
+ * How many plies to reduce a late quiet move by, growing with the log of both the depth and the
+ * number of moves already searched.
+ */
+auto lateMoveReduction(int depth, size_t moveNumber) -> int
+{
+  static const auto REDUCTIONS = [] {
+    std::array<std::array<int, 64>, 64> reductions{};
+    for (size_t d = 1; d < 64; ++d)
+    {
+      for (size_t m = 1; m < 64; ++m)
       {
-        maxEvaluation = evaluation;
-        bestMove = move;
+        reductions[d][m] = static_cast<int>(0.75 + std::log(d) * std::log(m) / 2.25);
+      }
+    }
+    return reductions;
+  }();
+
+  return REDUCTIONS[std::min(depth, 63)][std::min<size_t>(moveNumber, 63)];
+}
+
+/*
+ * The material of a side other than its pawns and king.
+ */
+auto nonPawnMaterial(const Board& board, PieceColour side) -> int
+{
+  int material{ 0 };
+  for (auto type : { PieceType::KNIGHT, PieceType::BISHOP, PieceType::ROOK, PieceType::QUEEN })
+  {
+    material += pieceValue(type) * bitboard::countSetBits(board.getPosition(side, type));
+  }
+  return material;
+}
 
-        if (evaluation > alpha)
-        {
-          alpha = evaluation;
-        }
+/*
+ * Negamax principal variation search: scores are from the point of view of the side to move, and
+ * every move after the first is searched with a null window around alpha, only to prove that it is
+ * no better. A move that proves to be better is searched again with the full window.
+ *
+ * Away from the principal variation, positions far enough outside the window near the leaves are
+ * pruned on their static evaluation, as are those where passing still fails high (null move), and
+ * quiet moves late in the order are searched shallower unless they prove to be good.
+ *
+ * Each ply keeps its moves, killers and best line in its entry of the context's stack, so the
+ * search allocates nothing. nullMove is false after a null move, so that two are never made in a
+ * row, and when verifying a null move cutoff. The move that led to the position, for the counter
+ * move, is the current move of the ply above, 0 after a null move.
+ */
+auto search(Board& board, int alpha, int beta, int depth, int ply, bool nullMove, SearchContext& context) -> int
+{
+  const bool root = (ply == 0);
+
+  if (depth <= 0)
+  {
+    return quiescence(board, alpha, beta, ply, context);
+  }
+
+  if (context.visit())
+  {
+    return 0;
+  }
+
+  SearchStack& stack = context.stack();
+  PlyState& state = stack[ply];
+  state.m_pvLength = 0;
+
+  if (ply >= MAX_PLY - 1)
+  {
+    return staticEvaluation(board);
+  }
+
+  // Mate distance pruning: no score here can beat being mated now or mating on the next move, so
+  // if the window is beyond them a shorter mate has already been found
+  if (not root)
+  {
+    alpha = std::max(alpha, matedIn(ply));
+    beta = std::min(beta, mateIn(ply + 1));
+
+    if (alpha >= beta)
+    {
+      return alpha;
+    }
+  }
+
+  // A search without the excluded move is of a different position as far as the table is concerned
+  const Move excluded = state.m_excludedMove;
+  const Move previous = root ? Move{} : stack[ply - 1].m_currentMove;
+
+  const zobrist::Key key = board.hash();
+  PackedMove hashMove{ 0 };
+
+  if (TranspositionTable* table = context.table())
+  {
+    if (const auto entry = table->probe(key))
+    {
+      hashMove = entry->m_move;
+      const int score = scoreFromTable(entry->m_score, ply);
+
+      // The root has to return its best move, so it is always searched
+      const bool cutoff = (entry->m_bound == Bound::EXACT)
+        || (entry->m_bound == Bound::LOWER && score >= beta)
+        || (entry->m_bound == Bound::UPPER && score <= alpha);
+
+      if (not root && excluded == Move{} && entry->m_depth >= depth && cutoff)
+      {
+        return score;
       }
+    }
+  }
+
+  const SearchOptions& options = context.options();
+  const PieceColour side = board.sideToMove();
+  const bool pvNode = (beta - alpha > 1);
+  const bool inCheck = board.isCheck();
+  const int staticEval = inCheck ? -INFINITE_SCORE : staticEvaluation(board);
+  state.m_staticEval = staticEval;
+
+  // Pruning on the static evaluation is never done in check, or to prove a mate
+  const bool canPrune = not pvNode && not inCheck && not isMateScore(beta);
+
+  if (canPrune && options.m_reverseFutility && depth <= REVERSE_FUTILITY_DEPTH
+      && staticEval - REVERSE_FUTILITY_MARGIN * depth >= beta)
+  {
+    return staticEval;
+  }
+
+  if (canPrune && options.m_razoring && depth <= RAZORING_DEPTH && staticEval + RAZORING_MARGIN * depth <= alpha)
+  {
+    const int score = quiescence(board, alpha, beta, ply, context);
+    if (context.stopped()) return 0;
+    if (score <= alpha) return score;
+  }
+
+  if (canPrune && options.m_nullMove && nullMove && excluded == Move{} && depth >= NULL_MOVE_DEPTH && staticEval >= beta)
+  {
+    const int material = nonPawnMaterial(board, side);
+    const int nullDepth = depth - 1 - NULL_MOVE_REDUCTION - depth / NULL_MOVE_DEPTH_DIVISOR;
+
+    if (material > 0)
+    {
+      state.m_currentMove = Move{};
 
-      if (beta <= alpha)
+      board.makeNullMove();
+      int score = -search(board, -beta, -beta + 1, nullDepth, ply + 1, false, context);
+      board.undoNullMove();
+
+      if (context.stopped()) return 0;
+
+      if (score >= beta)
       {
-        break;
+        // A mate found after passing isn't a mate the position can force
+        score = std::min(score, beta);
+
+        if (material >= ZUGZWANG_MATERIAL) return score;
+
+        // Verify by searching the position itself as shallowly, with null moves off at the root
+        const int verified = search(board, beta - 1, beta, nullDepth, ply, false, context);
+        if (context.stopped()) return 0;
+        if (verified >= beta) return score;
       }
     }
+  }
 
-    return { maxEvaluation, bestMove };
+  state.m_moveCount = board.generateMoves(state.m_moves.data());
+
+  if (state.m_moveCount == 0)
+  {
+    return inCheck ? matedIn(ply) : DRAW_SCORE;
+  }
+
+  if (excluded != Move{})
+  {
+    const auto moves = state.moves();
+    state.m_moveCount = std::remove(moves.begin(), moves.end(), excluded) - moves.begin();
+
+    // Nothing is better than alpha if there is nothing else
+    if (state.m_moveCount == 0) return alpha;
   }
 
-  int minEvaluation = std::numeric_limits<int>::max();
-  for (const auto& move : board.generateMoves())
+  // Quiet moves that don't give check can't bring a futile position up to alpha
+  const bool futile = canPrune && options.m_futility && depth <= FUTILITY_DEPTH
+    && staticEval + FUTILITY_MARGIN * depth <= alpha;
+
+  MovePicker picker{ board, state.moves(), hashMove, context.history(), side, state.m_killers, previous };
+
+  // The quiet moves searched so far, whose history falls if a later quiet move cuts off
+  std::array<Move, MAX_MOVES> quiets;
+  size_t quietCount{ 0 };
+
+  const int originalAlpha = alpha;
+
+  int bestScore = -INFINITE_SCORE;
+  Move bestMove;
+
+  Move move;
+  for (size_t i = 0; picker.next(move); ++i)
   {
+    const bool quiet = isQuiet(move);
+    const bool givesCheck = quiet && i > 0 && not inCheck && board.givesCheck(move);
+
+    if (futile && quiet && i > 0 && not givesCheck)
+    {
+      continue;
+    }
+
+    int reduction{ 0 };
+    if (options.m_lateMoveReductions && depth >= LMR_DEPTH && i >= LMR_MOVES && quiet && not inCheck && not givesCheck)
+    {
+      reduction = lateMoveReduction(depth, i);
+
+      // Less on the principal variation and for moves that have often cut off, more for moves
+      // that lose material
+      if (pvNode) --reduction;
+      reduction -= context.history().history(side, move) / (MoveHistory::MAX_HISTORY / 2);
+      if (not board.seeGe(move, 0)) ++reduction;
+
+      reduction = std::clamp(reduction, 0, depth - 2);
+    }
+
+    if (quiet) quiets[quietCount++] = move;
+
+    state.m_currentMove = move;
     board.makeMove(move);
 
-    if (board.isCheckmate())
+    int score{ 0 };
+    if (i == 0)
     {
-      board.undoMove();
-      return { std::numeric_limits<int>::min(), move };
+      score = -search(board, -beta, -alpha, depth - 1, ply + 1, true, context);
+    }
+    else
+    {
+      score = -search(board, -alpha - 1, -alpha, depth - 1 - reduction, ply + 1, true, context);
+
+      // A reduced move that beats alpha is searched again at full depth before it is believed
+      if (reduction > 0 && score > alpha)
+      {
+        score = -search(board, -alpha - 1, -alpha, depth - 1, ply + 1, true, context);
+      }
+
+      if (score > alpha && score < beta)
+      {
+        score = -search(board, -beta, -alpha, depth - 1, ply + 1, true, context);
+      }
     }
 
-    auto [evaluation, _] = alphaBeta(board, alpha, beta, depth - 1, true);
     board.undoMove();
 
-    if (evaluation < minEvaluation)
+    if (context.stopped())
+    {
+      return 0;
+    }
+
+    if (score > bestScore)
     {
-      minEvaluation = evaluation;
+      bestScore = score;
       bestMove = move;
 
-      if (evaluation < beta)
+      // The root keeps its best move even when it fails low, as it has to return one
+      if (score > alpha || root)
       {
-        beta = evaluation;
+        stack.updatePv(ply, move);
+      }
+
+      if (score > alpha)
+      {
+        alpha = score;
       }
     }
 
-    if (beta <= alpha)
+    if (alpha >= beta)
     {
+      if (isQuiet(move))
+      {
+        state.addKiller(move);
+        context.history().update(side, depth, previous, std::span{ quiets.data(), quietCount });
+      }
       break;
     }
   }
 
-  return { minEvaluation, bestMove };
+  if (excluded != Move{}) return bestScore;
+  return store(context, key, depth, ply, originalAlpha, beta, bestScore, bestMove);
+}
+
+} // namespace
+
+std::pair<int, Move> alphaBeta(Board& board, int depth, PieceColour us)
+{
+  SearchContext context{ nullptr };
+  auto [score, move] = alphaBeta(board, -INFINITE_SCORE, INFINITE_SCORE, depth, context);
+  return { (board.sideToMove() == us) ? score : -score, move };
+}
+
+std::pair<int, Move> alphaBeta(Board& board, int alpha, int beta, int depth)
+{
+  SearchContext context{ nullptr };
+  return alphaBeta(board, alpha, beta, depth, context);
+}
+
+std::pair<int, Move> alphaBeta(Board& board, int depth, PieceColour us, TranspositionTable& table)
+{
+  table.newSearch();
 
+  SearchContext context{ &table };
+  auto [score, move] = alphaBeta(board, -INFINITE_SCORE, INFINITE_SCORE, depth, context);
+  return { (board.sideToMove() == us) ? score : -score, move };
+}
+
+std::pair<int, Move> alphaBeta(Board& board, int alpha, int beta, int depth, SearchContext& context)
+{
+  const int score = search(board, alpha, beta, depth, 0, false, context);
+  const auto pv = context.principalVariation();
+  return { score, pv.empty() ? Move{} : pv.front() };
+}
+
+auto pieceValue(PieceType type) -> int
+{
+  static constexpr int PIECE_VALUES[]{ 1, 3, 3, 5, 8, 0 };
+  return PIECE_VALUES[static_cast<int>(type)];
 }
 
 int evaluate(Board& board)
@@ -5,9 +5,41 @@ namespace yak { class Board; }
 
 namespace yak::engine {
 
+class SearchContext;
+class TranspositionTable;
+
+/*
+ * The material value of a piece, in the units of evaluate.
+ */
+auto pieceValue(PieceType type) -> int;
+
+/*
+ * A static evaluation of the position, from white's point of view.
+ */
 int evaluate(Board& board);
 
+/*
+ * The score of the position from the point of view of us, and its best move.
+ */
 std::pair<int, Move> alphaBeta(Board& board, int depth, PieceColour us);
-std::pair<int, Move> alphaBeta(Board& board, int alpha, int beta, int depth, bool maximise);
+
+/*
+ * The score of the position within the window alpha to beta, from the point of view of the side
+ * to move, and its best move. A score at or below alpha is only an upper bound on the true score,
+ * and one at or above beta only a lower bound. The window must be within +-INFINITE_SCORE.
+ */
+std::pair<int, Move> alphaBeta(Board& board, int alpha, int beta, int depth);
+
+/*
+ * As above, remembering the results of the search in the table, to cut off positions already
+ * searched deeply enough and to try their best moves first. The table can be kept between calls.
+ */
+std::pair<int, Move> alphaBeta(Board& board, int depth, PieceColour us, TranspositionTable& table);
+
+/*
+ * A search of the root of a search in progress, counting its nodes in the context and stopping when
+ * the context says so. The principal variation is left in the context.
+ */
+std::pair<int, Move> alphaBeta(Board& board, int alpha, int beta, int depth, SearchContext& context);
 
 } // namespace yak::engine
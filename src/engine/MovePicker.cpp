@@ -0,0 +1,113 @@
+#include "MovePicker.h"
+#include "AlphaBeta.h"
+
+#include <algorithm>
+#include <cstdlib>
+#include <utility>
+
+namespace yak::engine {
+
+namespace {
+
+// Bands of move scores, so that each kind of move is ordered ahead of the next whatever its score
+// within the band
+static constexpr int HASH_MOVE_SCORE{ 1 << 30 };
+static constexpr int CAPTURE_SCORE{ 1 << 28 };
+static constexpr int KILLER_SCORE{ 1 << 26 };
+static constexpr int COUNTER_MOVE_SCORE{ 1 << 25 };
+static constexpr int BAD_CAPTURE_SCORE{ -(1 << 28) };
+
+} // namespace
+
+void MoveHistory::clear()
+{
+  *this = MoveHistory{};
+}
+
+void MoveHistory::update(PieceColour side, int depth, Move previous, std::span<const Move> tried)
+{
+  const Move best = tried.back();
+
+  if (previous != Move{})
+  {
+    m_counterMoves[index(side)][from(previous)][to(previous)] = best;
+  }
+
+  const int bonus = std::min(depth * depth, MAX_HISTORY / 4);
+
+  addHistory(side, best, bonus);
+  for (const auto& move : tried.first(tried.size() - 1))
+  {
+    addHistory(side, move, -bonus);
+  }
+}
+
+void MoveHistory::addHistory(PieceColour side, Move move, int bonus)
+{
+  // Scale the bonus down as the score nears the limit, so scores saturate rather than overflow,
+  // and moves that used to cut off but no longer do lose their place quickly
+  int& score = m_history[index(side)][from(move)][to(move)];
+  score += bonus - score * std::abs(bonus) / MAX_HISTORY;
+}
+
+MovePicker::MovePicker(const Board& board, std::span<Move> moves, PackedMove hashMove)
+  : m_moves(moves)
+{
+  for (size_t i = 0; i < moves.size(); ++i)
+  {
+    const Move move = moves[i];
+
+    if (hashMove && packMove(move) == hashMove) m_scores[i] = HASH_MOVE_SCORE;
+    else if (isQuiet(move)) m_scores[i] = 0;
+    else if (board.seeGe(move, 0)) m_scores[i] = CAPTURE_SCORE + mvvLva(move);
+    else m_scores[i] = BAD_CAPTURE_SCORE + mvvLva(move);
+  }
+}
+
+MovePicker::MovePicker(const Board& board,
+                       std::span<Move> moves,
+                       PackedMove hashMove,
+                       const MoveHistory& history,
+                       PieceColour side,
+                       const std::array<Move, 2>& killers,
+                       Move previous)
+  : MovePicker(board, moves, hashMove)
+{
+  const Move counterMove = (previous != Move{}) ? history.counterMove(side, previous) : Move{};
+
+  for (size_t i = 0; i < moves.size(); ++i)
+  {
+    const Move move = moves[i];
+    if (not isQuiet(move) || m_scores[i] == HASH_MOVE_SCORE) continue;
+
+    if (move == killers[0]) m_scores[i] = KILLER_SCORE + 1;
+    else if (move == killers[1]) m_scores[i] = KILLER_SCORE;
+    else if (move == counterMove) m_scores[i] = COUNTER_MOVE_SCORE;
+    else m_scores[i] = history.history(side, move);
+  }
+}
+
+auto MovePicker::next(Move& move) -> bool
+{
+  if (m_next == m_moves.size()) return false;
+
+  size_t best = m_next;
+  for (size_t i = m_next + 1; i < m_moves.size(); ++i)
+  {
+    if (m_scores[i] > m_scores[best]) best = i;
+  }
+
+  std::swap(m_moves[m_next], m_moves[best]);
+  std::swap(m_scores[m_next], m_scores[best]);
+
+  move = m_moves[m_next++];
+  return true;
+}
+
+auto mvvLva(Move move) -> int
+{
+  if (not isCapture(move)) return isPromotion(move) ? pieceValue(promotion(move)) : 0;
+  return 8 * pieceValue(captured(move)) - pieceValue(moved(move)) + 8;
+}
+
+} // namespace yak::engine
@@ -0,0 +1,99 @@
+#pragma once
+
+#include "TranspositionTable.h"
+
+#include <array>
+#include <cstddef>
+#include <span>
+
+#include <board.h>
+#include "types.h"
+
+namespace yak::engine {
+
+/*
+ * What a search has learnt about quiet moves, for ordering them: a butterfly history of how often
+ * each move by each side has caused a cutoff, and the move that last refuted each move of the
+ * opponent. The killers of each ply are kept in the SearchStack.
+ *
+ * Each search thread has its own, kept for the whole of the search.
+ */
+class MoveHistory
+{
+public:
+  /* History scores stay within +-MAX_HISTORY. */
+  static constexpr int MAX_HISTORY{ 1 << 14 };
+
+  void clear();
+
+  auto history(PieceColour side, Move move) const -> int
+  {
+    return m_history[index(side)][from(move)][to(move)];
+  }
+
+  /* The refutation of the opponent's previous move, or 0 if there is none. */
+  auto counterMove(PieceColour side, Move previous) const -> Move
+  {
+    return m_counterMoves[index(side)][from(previous)][to(previous)];
+  }
+
+  /*
+   * Record that the quiet move best caused a beta cutoff, at depth, after all of the quiet moves
+   * in tried (which ends with best) were searched. best becomes the counter to the previous move,
+   * its history rises with the depth, and the history of the other moves falls.
+   */
+  void update(PieceColour side, int depth, Move previous, std::span<const Move> tried);
+
+private:
+  static auto index(PieceColour side) -> size_t { return (side == PieceColour::WHITE) ? 1 : 0; }
+
+  void addHistory(PieceColour side, Move move, int bonus);
+
+  std::array<std::array<std::array<int, 64>, 64>, 2> m_history{};
+  std::array<std::array<std::array<Move, 64>, 64>, 2> m_counterMoves{};
+};
+
+/*
+ * Hands out the moves of a position best first: the move from the transposition table, captures
+ * and promotions that don't lose material by MVV-LVA, the killers, the counter move, the other
+ * quiet moves by history, and last the captures that lose material by static exchange.
+ *
+ * Moves are scored up front, but only sorted as they are asked for, by picking the best of the
+ * rest each time, as a cutoff often comes before most of them have been looked at.
+ */
+class MovePicker
+{
+public:
+  /* Without a history, quiet moves come in generation order. */
+  MovePicker(const Board& board, std::span<Move> moves, PackedMove hashMove);
+
+  MovePicker(const Board& board,
+             std::span<Move> moves,
+             PackedMove hashMove,
+             const MoveHistory& history,
+             PieceColour side,
+             const std::array<Move, 2>& killers,
+             Move previous);
+
+  /* The next best move, false once every move has been handed out. */
+  auto next(Move& move) -> bool;
+
+private:
+  std::span<Move> m_moves;
+  std::array<int, MAX_MOVES> m_scores;
+  size_t m_next{ 0 };
+};
+
+/*
+ * Most valuable victim, least valuable attacker: captures of the most valuable pieces first, and
+ * of pieces of the same value with the least valuable attacker first. Promotions are ordered by
+ * the piece promoted to. Quiet moves score 0.
+ */
+auto mvvLva(Move move) -> int;
+
+inline auto isQuiet(Move move) -> bool
+{
+  return not isCapture(move) && not isPromotion(move);
+}
+
+} // namespace yak::engine
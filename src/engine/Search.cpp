@@ -0,0 +1,299 @@
+#include "Search.h"
+#include "AlphaBeta.h"
+#include "TranspositionTable.h"
+
+#include <board.h>
+#include <perft/Perft.h>
+
+#include <algorithm>
+#include <cstdlib>
+#include <future>
+#include <iterator>
+#include <memory>
+#include <optional>
+#include <string>
+#include <vector>
+
+namespace yak::engine {
+
+namespace {
+
+// Time kept back from every move on the clock, for the latency of reporting the move
+static constexpr std::chrono::milliseconds MOVE_OVERHEAD{ 10 };
+
+// Moves the remaining time is spread over when there is no time control
+static constexpr int DEFAULT_MOVES_TO_GO{ 30 };
+
+/*
+ * How long to search for. No new iteration is started after the optimum time, as it is unlikely
+ * to finish, and the iteration in progress is stopped at the maximum.
+ */
+struct TimeBudget
+{
+  std::chrono::milliseconds m_optimum;
+  std::chrono::milliseconds m_maximum;
+};
+
+auto timeBudget(const SearchLimits& limits, PieceColour side) -> std::optional<TimeBudget>
+{
+  if (limits.m_infinite) return std::nullopt;
+
+  if (limits.m_moveTime.count() > 0)
+  {
+    const auto time = std::max(limits.m_moveTime - MOVE_OVERHEAD, std::chrono::milliseconds{ 1 });
+    return TimeBudget{ time, time };
+  }
+
+  const bool white = (side == PieceColour::WHITE);
+  const auto remaining = white ? limits.m_whiteTime : limits.m_blackTime;
+  const auto increment = white ? limits.m_whiteIncrement : limits.m_blackIncrement;
+
+  if (remaining.count() <= 0) return std::nullopt;
+
+  const int movesToGo = (limits.m_movesToGo > 0) ? limits.m_movesToGo : DEFAULT_MOVES_TO_GO;
+  const auto available = std::max(remaining - MOVE_OVERHEAD, std::chrono::milliseconds{ 1 });
+
+  const auto optimum = std::min(available / movesToGo + increment * 3 / 4, available);
+  const auto maximum = std::min(optimum * 3, available);
+  return TimeBudget{ optimum, maximum };
+}
+
+// Half the width of the first aspiration window around the score of the previous iteration
+static constexpr int ASPIRATION_WINDOW{ 5 };
+
+// Iterations shallower than this are searched with the full window, as their scores swing widely
+static constexpr int ASPIRATION_DEPTH{ 4 };
+
+/*
+ * Search the root with a narrow window around the score of the previous iteration, which cuts off
+ * far more than the full window when the score changes little. A score outside the window is only
+ * a bound, so the search is repeated with the window widened on that side, twice as far each time.
+ */
+auto aspirationSearch(Board& board, int depth, int previousScore, SearchContext& context) -> std::pair<int, Move>
+{
+  if (depth < ASPIRATION_DEPTH || isMateScore(previousScore))
+  {
+    return alphaBeta(board, -INFINITE_SCORE, INFINITE_SCORE, depth, context);
+  }
+
+  int delta = ASPIRATION_WINDOW;
+  int alpha = std::max(previousScore - delta, -INFINITE_SCORE);
+  int beta = std::min(previousScore + delta, INFINITE_SCORE);
+
+  while (true)
+  {
+    auto result = alphaBeta(board, alpha, beta, depth, context);
+    const int score = result.first;
+
+    if (context.stopped()) return result;
+
+    delta *= 2;
+
+    if (score <= alpha)
+    {
+      alpha = std::max(score - delta, -INFINITE_SCORE);
+    }
+    else if (score >= beta)
+    {
+      beta = std::min(score + delta, INFINITE_SCORE);
+    }
+    else
+    {
+      return result;
+    }
+  }
+}
+
+// Helper threads skip iterations in these patterns, one for each of the first helpers, so that at
+// any time they are spread over the depths around the main thread's rather than all searching the
+// same one
+static constexpr int SKIP_SIZE[]{ 1, 1, 2, 2, 2, 2, 3, 3, 3, 3, 3, 3, 4, 4, 4, 4, 4, 4, 4, 4 };
+static constexpr int SKIP_PHASE[]{ 0, 1, 0, 1, 2, 3, 0, 1, 2, 3, 4, 5, 0, 1, 2, 3, 4, 5, 6, 7 };
+
+/*
+ * Search the position on a helper thread, with its own board, history and stack, until stop is
+ * set or maxDepth is done. Its results only reach the main thread through the table. Returns the
+ * number of nodes searched.
+ */
+auto helperSearch(const std::string& fen,
+                  size_t helper,
+                  int maxDepth,
+                  TranspositionTable& table,
+                  const std::atomic<bool>& stop,
+                  std::atomic<uint64_t>& nodes,
+                  const SearchOptions& options) -> uint64_t
+{
+  Board board{ fen };
+
+  SearchContext context{ &table, &stop };
+  context.setOptions(options);
+  context.setNodeCounter(&nodes);
+  context.enableLimits(true);
+
+  const size_t pattern = (helper - 1) % std::size(SKIP_SIZE);
+
+  int score{ 0 };
+  for (int depth = 1; depth <= maxDepth; ++depth)
+  {
+    if (((depth + SKIP_PHASE[pattern]) / SKIP_SIZE[pattern]) % 2) continue;
+
+    score = aspirationSearch(board, depth, score, context).first;
+    if (context.stopped()) break;
+  }
+
+  return context.nodes();
+}
+
+/*
+ * The pool the helpers run on, kept between searches so that its threads are only started again
+ * when the number of helpers changes.
+ */
+auto helperPool(size_t helpers) -> ThreadPool&
+{
+  static std::unique_ptr<ThreadPool> pool;
+  if (not pool || pool->size() != helpers) pool = std::make_unique<ThreadPool>(helpers);
+  return *pool;
+}
+
+/*
+ * The helper threads of a search, started on construction. They only stop when the main thread
+ * does, so they are stopped, and waited for, however the main thread's search ends.
+ */
+class Helpers
+{
+public:
+  Helpers(const Board& board, size_t threads, int maxDepth, TranspositionTable& table, const SearchOptions& options)
+  {
+    if (threads <= 1) return;
+
+    const std::string fen = board.toFen();
+    auto& pool = helperPool(threads - 1);
+
+    for (size_t helper = 1; helper < threads; ++helper)
+    {
+      m_helpers.push_back(pool.enqueue([this, fen, helper, maxDepth, &table, options] {
+        return helperSearch(fen, helper, maxDepth, table, m_stop, m_nodes, options);
+      }));
+    }
+  }
+
+  ~Helpers()
+  {
+    m_stop.store(true, std::memory_order_relaxed);
+    for (auto& helper : m_helpers)
+    {
+      if (helper.valid()) helper.wait();
+    }
+  }
+
+  Helpers(const Helpers&) = delete;
+  Helpers& operator=(const Helpers&) = delete;
+
+  /* The nodes searched by the helpers so far, counted CHECK_INTERVAL at a time. */
+  auto nodes() const -> uint64_t { return m_nodes.load(std::memory_order_relaxed); }
+
+  /* Stop the helpers, returning the exact number of nodes they searched. */
+  auto stop() -> uint64_t
+  {
+    m_stop.store(true, std::memory_order_relaxed);
+
+    uint64_t nodes{ 0 };
+    for (auto& helper : m_helpers)
+    {
+      nodes += helper.get();
+    }
+    m_helpers.clear();
+
+    return nodes;
+  }
+
+private:
+  std::atomic<bool> m_stop{ false };
+  std::atomic<uint64_t> m_nodes{ 0 };
+  std::vector<std::future<uint64_t>> m_helpers;
+};
+
+} // namespace
+
+void SearchContext::checkLimits()
+{
+  if (m_nodeCounter && (m_nodes % CHECK_INTERVAL) == 0)
+  {
+    m_nodeCounter->fetch_add(CHECK_INTERVAL, std::memory_order_relaxed);
+  }
+
+  if (not m_limitsEnabled) return;
+
+  if (m_stop && m_stop->load(std::memory_order_relaxed))
+  {
+    m_stopped = true;
+  }
+  else if (m_nodeLimit && m_nodes >= m_nodeLimit)
+  {
+    m_stopped = true;
+  }
+  else if (m_deadline != Clock::time_point::max() && Clock::now() >= m_deadline)
+  {
+    m_stopped = true;
+  }
+}
+
+auto search(Board& board,
+            const SearchLimits& limits,
+            TranspositionTable& table,
+            const std::atomic<bool>& stop,
+            const std::function<void(const SearchResult&)>& report,
+            const SearchOptions& options) -> SearchResult
+{
+  const auto start = SearchContext::Clock::now();
+  const auto side = board.sideToMove();
+  const auto budget = timeBudget(limits, side);
+
+  table.newSearch();
+
+  SearchContext context{ &table, &stop };
+  context.setOptions(options);
+  context.setNodeLimit(limits.m_nodes);
+  if (budget) context.setDeadline(start + budget->m_maximum);
+
+  const int maxDepth = (limits.m_depth > 0) ? std::min(limits.m_depth, MAX_DEPTH) : MAX_DEPTH;
+
+  Helpers helpers{ board, options.m_threads, maxDepth, table, options };
+
+  SearchResult result{};
+  for (int depth = 1; depth <= maxDepth; ++depth)
+  {
+    auto [score, move] = aspirationSearch(board, depth, result.m_score, context);
+
+    const auto elapsed = SearchContext::Clock::now() - start;
+    result.m_nodes = context.nodes() + helpers.nodes();
+    result.m_seconds = std::chrono::duration<double>(elapsed).count();
+
+    if (context.stopped()) break;
+
+    const auto pv = context.principalVariation();
+
+    result.m_bestMove = move;
+    result.m_score = score;
+    result.m_depth = depth;
+    result.m_pv.assign(pv.begin(), pv.end());
+
+    if (report) report(result);
+
+    // Limits only apply once there is a move to play
+    context.enableLimits(true);
+
+    // Nothing changes deeper once there are no moves, or a mate has been found within the depth
+    // searched, as a shorter one would have been found first
+    if (move == Move{} || (isMateScore(score) && MATE_SCORE - std::abs(score) <= depth)) break;
+    if (stop.load(std::memory_order_relaxed)) break;
+    if (limits.m_nodes && context.nodes() >= limits.m_nodes) break;
+    if (budget && elapsed >= budget->m_optimum) break;
+  }
+
+  result.m_nodes = context.nodes() + helpers.stop();
+
+  return result;
+}
+
+} // namespace yak::engine
@@ -0,0 +1,224 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <span>
+#include <vector>
+
+#include "MovePicker.h"
+#include "SearchStack.h"
+#include "types.h"
+
+namespace yak::engine {
+
+class TranspositionTable;
+
+static constexpr int MAX_DEPTH{ 64 };
+
+/*
+ * Scores are bounded well within the range of int (and of the 16 bits kept by the table), so that
+ * they can always be negated. No score is as large as INFINITE_SCORE.
+ *
+ * A mate is scored MATE_SCORE less the number of plies from the root to the mate, so that shorter
+ * mates score higher and longer defences against a mate score higher for the side being mated.
+ * Every score beyond +-MATE_BOUND is a mate.
+ */
+static constexpr int INFINITE_SCORE{ 32001 };
+static constexpr int MATE_SCORE{ 32000 };
+static constexpr int MATE_BOUND{ MATE_SCORE - MAX_PLY };
+static constexpr int DRAW_SCORE{ 0 };
+
+/* The score of mating at ply, and of being mated at ply. */
+constexpr auto mateIn(int ply) -> int { return MATE_SCORE - ply; }
+constexpr auto matedIn(int ply) -> int { return -MATE_SCORE + ply; }
+
+constexpr auto isMateScore(int score) -> bool { return score >= MATE_BOUND || score <= -MATE_BOUND; }
+
+/*
+ * When to stop a search. Every limit that is set applies, and the search stops at the first one
+ * reached. With none set the search runs to MAX_DEPTH, or until it is stopped.
+ */
+struct SearchLimits
+{
+  /* Deepest iteration to search, 0 for no limit. */
+  int m_depth{ 0 };
+
+  /* Stop after this many nodes, 0 for no limit. */
+  uint64_t m_nodes{ 0 };
+
+  /* Time to spend on the move, 0 to budget from the clock instead. */
+  std::chrono::milliseconds m_moveTime{ 0 };
+
+  /* Time left on each side's clock and their increments, used when there is no move time. */
+  std::chrono::milliseconds m_whiteTime{ 0 };
+  std::chrono::milliseconds m_blackTime{ 0 };
+  std::chrono::milliseconds m_whiteIncrement{ 0 };
+  std::chrono::milliseconds m_blackIncrement{ 0 };
+
+  /* Moves until the next time control, 0 if the rest of the game must be played on the clock. */
+  int m_movesToGo{ 0 };
+
+  /* Ignore the clock, searching until stopped or another limit is reached. */
+  bool m_infinite{ false };
+};
+
+/*
+ * How the search is run: the number of threads, and switches for the pruning of the search, so that
+ * each can be turned off to measure what it gains.
+ */
+struct SearchOptions
+{
+  /*
+   * Threads to search with (Lazy SMP): the main thread, which reports the results, and helpers that
+   * search the same position at staggered depths, sharing what they find through the table.
+   */
+  size_t m_threads{ 1 };
+
+  /* Skip captures in quiescence that can't bring the score up to alpha. */
+  bool m_deltaPruning{ true };
+
+  /* Skip captures in quiescence that lose material by static exchange. */
+  bool m_seePruning{ true };
+
+  /* Cut off when passing the move still fails high, verified when zugzwang is likely. */
+  bool m_nullMove{ true };
+
+  /* Search quiet moves late in the order shallower, unless they beat alpha. */
+  bool m_lateMoveReductions{ true };
+
+  /* Cut off near the leaves when the static evaluation is well above beta. */
+  bool m_reverseFutility{ true };
+
+  /* Skip quiet moves near the leaves when the static evaluation is well below alpha. */
+  bool m_futility{ true };
+
+  /* Drop into quiescence near the leaves when the static evaluation is well below alpha. */
+  bool m_razoring{ true };
+
+  /*
+   * Options without the pruning that depends on the window or the move order, so that a search
+   * finds the same score as plain negamax, whatever the table holds.
+   */
+  static auto exact() -> SearchOptions
+  {
+    SearchOptions options{};
+    options.m_deltaPruning = false;
+    options.m_nullMove = false;
+    options.m_lateMoveReductions = false;
+    options.m_reverseFutility = false;
+    options.m_futility = false;
+    options.m_razoring = false;
+    return options;
+  }
+};
+
+struct SearchResult
+{
+  Move m_bestMove{};
+
+  /* Score of the best move, from the point of view of the side to move. */
+  int m_score{ 0 };
+
+  /* The last iteration completed. */
+  int m_depth{ 0 };
+
+  /* The line expected from the best move on. */
+  std::vector<Move> m_pv;
+
+  uint64_t m_nodes{ 0 };
+  double m_seconds{ 0.0 };
+};
+
+/*
+ * The state of a search in progress shared by its nodes: the table, the options, the history of
+ * moves for ordering, the stack of the line being searched, the number of nodes searched and
+ * whether it is time to stop.
+ *
+ * Every node calls visit(), which is cheap: the stop flag and the clock are only looked at every
+ * CHECK_INTERVAL nodes. Once stopped, the search unwinds as fast as it can and the scores it
+ * returns are meaningless.
+ */
+class SearchContext
+{
+public:
+  static constexpr uint64_t CHECK_INTERVAL{ 1024 };
+
+  using Clock = std::chrono::steady_clock;
+
+  SearchContext(TranspositionTable* table, const std::atomic<bool>* stop = nullptr)
+    : m_table(table)
+    , m_stop(stop)
+  {
+  }
+
+  auto table() const -> TranspositionTable* { return m_table; }
+  auto options() const -> const SearchOptions& { return m_options; }
+  auto history() -> MoveHistory& { return m_history; }
+  auto stack() -> SearchStack& { return m_stack; }
+  auto nodes() const -> uint64_t { return m_nodes; }
+  auto stopped() const -> bool { return m_stopped; }
+
+  /* The principal variation of the last search of the root. */
+  auto principalVariation() const -> std::span<const Move> { return m_stack[0].pv(); }
+
+  void setOptions(const SearchOptions& options) { m_options = options; }
+
+  /* Also add the nodes to counter, CHECK_INTERVAL at a time, so other threads can follow them. */
+  void setNodeCounter(std::atomic<uint64_t>* counter) { m_nodeCounter = counter; }
+
+  /* Stop at the deadline, or after the given number of nodes (0 for no limit). */
+  void setDeadline(Clock::time_point deadline) { m_deadline = deadline; }
+  void setNodeLimit(uint64_t nodes) { m_nodeLimit = nodes; }
+
+  /* Whether limits apply; the first iteration is always completed so there is a move to play. */
+  void enableLimits(bool enabled) { m_limitsEnabled = enabled; }
+
+  /* Count a node, returning true if the search should stop. Nodes after the stop aren't counted. */
+  auto visit() -> bool
+  {
+    if (m_stopped) return true;
+
+    ++m_nodes;
+    if ((m_nodes % CHECK_INTERVAL) == 0 || m_nodes == m_nodeLimit) checkLimits();
+    return m_stopped;
+  }
+
+private:
+  void checkLimits();
+
+  TranspositionTable* m_table{ nullptr };
+  const std::atomic<bool>* m_stop{ nullptr };
+  std::atomic<uint64_t>* m_nodeCounter{ nullptr };
+  SearchOptions m_options;
+  MoveHistory m_history;
+  SearchStack m_stack;
+
+  uint64_t m_nodes{ 0 };
+  uint64_t m_nodeLimit{ 0 };
+  Clock::time_point m_deadline{ Clock::time_point::max() };
+
+  bool m_limitsEnabled{ false };
+  bool m_stopped{ false };
+};
+
+/*
+ * Search the position by iterative deepening, one ply deeper each iteration, until a limit is
+ * reached or stop is set. Returns the best move of the last iteration to complete.
+ *
+ * report, if given, is called with the result of each iteration as it completes.
+ *
+ * With more than one thread, the limits apply to the main thread, which stops the helpers when it
+ * stops. The nodes reported are those of every thread. The helpers' threads are kept for the next
+ * search, so only one search with helpers can run at a time.
+ */
+auto search(Board& board,
+            const SearchLimits& limits,
+            TranspositionTable& table,
+            const std::atomic<bool>& stop,
+            const std::function<void(const SearchResult&)>& report = {},
+            const SearchOptions& options = {}) -> SearchResult;
+
+} // namespace yak::engine
@@ -0,0 +1,90 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <memory>
+#include <span>
+
+#include <board.h>
+#include "types.h"
+
+namespace yak::engine {
+
+/* The deepest ply a search can reach, quiescence included. */
+static constexpr int MAX_PLY{ 128 };
+
+/*
+ * What the search keeps about the position at one ply of the line it is searching.
+ */
+struct PlyState
+{
+  /* The legal moves of the position, generated in place. */
+  std::array<Move, MAX_MOVES> m_moves;
+  size_t m_moveCount{ 0 };
+
+  /* From the point of view of the side to move, -INFINITE_SCORE in check. */
+  int m_staticEval{ 0 };
+
+  /* Quiet moves that caused a beta cutoff in other positions at this ply, the latest first. */
+  std::array<Move, 2> m_killers{};
+
+  /* The move being searched, 0 while a null move is. */
+  Move m_currentMove{};
+
+  /* A move to leave out of the search of the position, 0 for none. */
+  Move m_excludedMove{};
+
+  /* The best line found from the position. */
+  std::array<Move, MAX_PLY> m_pv;
+  size_t m_pvLength{ 0 };
+
+  auto moves() -> std::span<Move> { return { m_moves.data(), m_moveCount }; }
+  auto pv() const -> std::span<const Move> { return { m_pv.data(), m_pvLength }; }
+
+  void addKiller(Move move)
+  {
+    if (m_killers[0] != move)
+    {
+      m_killers[1] = m_killers[0];
+      m_killers[0] = move;
+    }
+  }
+};
+
+/*
+ * The state of every ply of the line being searched, allocated once for each search thread so that
+ * the recursion never allocates. Ply p searches with entry p and its children use entry p + 1, so
+ * nothing a node keeps in its entry is overwritten by the search below it.
+ *
+ * The principal variation is triangular: each entry holds the best line from its ply, which is its
+ * best move followed by the line of the entry below, copied up as the search unwinds.
+ */
+class SearchStack
+{
+public:
+  SearchStack()
+    : m_plies(std::make_unique<std::array<PlyState, MAX_PLY + 1>>())
+  {
+  }
+
+  auto operator[](int ply) -> PlyState& { return (*m_plies)[ply]; }
+  auto operator[](int ply) const -> const PlyState& { return (*m_plies)[ply]; }
+
+  /* The best line of ply becomes move, followed by the best line of the ply below. */
+  void updatePv(int ply, Move move)
+  {
+    PlyState& state = (*this)[ply];
+    const PlyState& child = (*this)[ply + 1];
+
+    state.m_pv[0] = move;
+    std::copy_n(child.m_pv.begin(), child.m_pvLength, state.m_pv.begin() + 1);
+    state.m_pvLength = child.m_pvLength + 1;
+  }
+
+private:
+  // One more than MAX_PLY, so that the last ply has a child to copy its line from
+  std::unique_ptr<std::array<PlyState, MAX_PLY + 1>> m_plies;
+};
+
+} // namespace yak::engine
@@ -0,0 +1,192 @@
+#include "TranspositionTable.h"
+
+#include <move.hpp>
+
+#include <algorithm>
+#include <limits>
+#include <new>
+
+namespace yak::engine {
+
+namespace {
+
+enum PackedKind : PackedMove
+{
+  NORMAL = 0,
+  PROMOTION,
+  KINGSIDE_CASTLE,
+  QUEENSIDE_CASTLE,
+};
+
+static constexpr int KIND_SHIFT{ 12 };
+static constexpr int PROMOTION_SHIFT{ 14 };
+
+} // namespace
+
+auto packMove(Move move) -> PackedMove
+{
+  if (isKingSideCastle(move)) return KINGSIDE_CASTLE << KIND_SHIFT;
+  if (isQueenSideCastle(move)) return QUEENSIDE_CASTLE << KIND_SHIFT;
+
+  PackedMove packed = static_cast<PackedMove>(from(move) | (to(move) << 6));
+
+  if (isPromotion(move))
+  {
+    const auto piece = static_cast<PackedMove>(pieceTypeToInt(promotion(move)) - pieceTypeToInt(PieceType::KNIGHT));
+    packed |= (PROMOTION << KIND_SHIFT) | (piece << PROMOTION_SHIFT);
+  }
+
+  return packed;
+}
+
+TranspositionTable::TranspositionTable(size_t megabytes)
+{
+  resize(megabytes);
+}
+
+void TranspositionTable::resize(size_t megabytes)
+{
+  // Round down to a power of two number of clusters, so the index is a mask of the hash.
+  size_t clusters{ 1 };
+  while (clusters * 2 * sizeof(Cluster) <= megabytes * 1024 * 1024)
+  {
+    clusters *= 2;
+  }
+
+  m_buffer = memory::LargeBuffer{ clusters * sizeof(Cluster) };
+  m_clusters = m_buffer.as<Cluster>();
+  m_mask = clusters - 1;
+
+  for (size_t i = 0; i < clusters; ++i)
+  {
+    new (&m_clusters[i]) Cluster{};
+  }
+
+  m_age = 0;
+}
+
+void TranspositionTable::clear()
+{
+  for (size_t i = 0; i <= m_mask; ++i)
+  {
+    for (auto& entry : m_clusters[i].m_entries)
+    {
+      entry.m_data.store(0, std::memory_order_relaxed);
+      entry.m_check.store(0, std::memory_order_relaxed);
+    }
+  }
+
+  m_age = 0;
+}
+
+void TranspositionTable::newSearch()
+{
+  m_age = (m_age + 1) & AGE_MASK;
+}
+
+auto TranspositionTable::probe(zobrist::Key key) const -> std::optional<TTEntry>
+{
+  const Cluster& cluster = m_clusters[key & m_mask];
+
+  for (const auto& entry : cluster.m_entries)
+  {
+    const uint64_t data = entry.m_data.load(std::memory_order_relaxed);
+    const uint64_t check = entry.m_check.load(std::memory_order_relaxed);
+
+    if ((check ^ data) == key && data != 0)
+    {
+      return unpack(data);
+    }
+  }
+
+  return std::nullopt;
+}
+
+void TranspositionTable::store(zobrist::Key key, int depth, int score, Bound bound, Move move)
+{
+  Cluster& cluster = m_clusters[key & m_mask];
+
+  // Replace the entry of the same position if there is one, otherwise the least valuable entry:
+  // an empty one, or the shallowest, counting entries of earlier searches as shallower the older
+  // they are.
+  Entry* replace{ nullptr };
+  uint64_t replaced{ 0 };
+  bool samePosition{ false };
+  int lowestValue{ std::numeric_limits<int>::max() };
+
+  for (auto& entry : cluster.m_entries)
+  {
+    const uint64_t data = entry.m_data.load(std::memory_order_relaxed);
+    const uint64_t check = entry.m_check.load(std::memory_order_relaxed);
+
+    if ((check ^ data) == key && data != 0)
+    {
+      replace = &entry;
+      replaced = data;
+      samePosition = true;
+      break;
+    }
+
+    const int relativeAge = (m_age - age(data)) & AGE_MASK;
+    const int value = (data == 0) ? std::numeric_limits<int>::min() : unpack(data).m_depth - 8 * relativeAge;
+    if (value < lowestValue)
+    {
+      lowestValue = value;
+      replace = &entry;
+    }
+  }
+
+  PackedMove packed = packMove(move);
+
+  if (samePosition)
+  {
+    const auto existing = unpack(replaced);
+
+    // Keep a deeper result of the same search, unless this one is exact
+    if (bound != Bound::EXACT && age(replaced) == m_age && existing.m_depth > depth + 2) return;
+
+    if (move == Move{}) packed = existing.m_move;
+  }
+  else if (move == Move{})
+  {
+    packed = 0;
+  }
+
+  const uint64_t data = static_cast<uint64_t>(packed)
+    | (static_cast<uint64_t>(static_cast<uint16_t>(static_cast<int16_t>(score))) << SCORE_SHIFT)
+    | (static_cast<uint64_t>(static_cast<uint8_t>(static_cast<int8_t>(depth))) << DEPTH_SHIFT)
+    | (static_cast<uint64_t>(bound) << BOUND_SHIFT)
+    | (static_cast<uint64_t>(m_age) << AGE_SHIFT);
+
+  replace->m_data.store(data, std::memory_order_relaxed);
+  replace->m_check.store(key ^ data, std::memory_order_relaxed);
+}
+
+auto TranspositionTable::hashfull() const -> int
+{
+  const size_t clusters = std::min<size_t>(1000 / ENTRIES_PER_CLUSTER, m_mask + 1);
+
+  int used{ 0 };
+  for (size_t i = 0; i < clusters; ++i)
+  {
+    for (const auto& entry : m_clusters[i].m_entries)
+    {
+      const uint64_t data = entry.m_data.load(std::memory_order_relaxed);
+      if (data != 0 && age(data) == m_age) ++used;
+    }
+  }
+
+  return static_cast<int>(used * 1000 / (clusters * ENTRIES_PER_CLUSTER));
+}
+
+auto TranspositionTable::unpack(uint64_t data) -> TTEntry
+{
+  TTEntry entry{};
+  entry.m_move = static_cast<PackedMove>(data);
+  entry.m_score = static_cast<int16_t>(data >> SCORE_SHIFT);
+  entry.m_depth = static_cast<int8_t>(data >> DEPTH_SHIFT);
+  entry.m_bound = static_cast<Bound>((data >> BOUND_SHIFT) & 0x3);
+  return entry;
+}
+
+} // namespace yak::engine
@@ -0,0 +1,124 @@
+#pragma once
+
+#include <LargeBuffer.h>
+#include <zobrist.h>
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+
+#include "types.h"
+
+namespace yak::engine {
+
+/*
+ * How a stored score relates to the true score of its position. A search that fails high only
+ * proves a LOWER bound, one that fails low an UPPER bound.
+ */
+enum class Bound : uint8_t
+{
+  NONE = 0,
+  UPPER,
+  LOWER,
+  EXACT,
+};
+
+/*
+ * A move packed into 16 bits for the table: the from and to squares, and in the top four bits the
+ * kind of move (normal, promotion, kingside or queenside castle) and the promoted piece. 0 is no
+ * move, as a1a1 is never legal.
+ */
+using PackedMove = uint16_t;
+
+auto packMove(Move move) -> PackedMove;
+
+/*
+ * What the table knows about a position.
+ */
+struct TTEntry
+{
+  PackedMove m_move{ 0 };
+  int m_score{ 0 };
+  int m_depth{ 0 };
+  Bound m_bound{ Bound::NONE };
+};
+
+/*
+ * A fixed size cache of search results, shared by every search thread without any locking.
+ *
+ * The table is an array of clusters, each a cache line holding ENTRIES_PER_CLUSTER entries, so a
+ * probe costs a single cache miss. A position can be stored in any entry of the cluster its hash
+ * picks. Each entry is two words, the data (move, score, depth, bound and age) and the hash XOR
+ * the data, written separately as in PerftHashTable: a reader that sees half of one write and half
+ * of another gets a hash that doesn't match, and treats the entry as a miss.
+ *
+ * Entries are aged by newSearch(), so that entries left by earlier searches are replaced ahead of
+ * deeper ones from the current search.
+ */
+class TranspositionTable
+{
+public:
+  static constexpr size_t ENTRIES_PER_CLUSTER{ 4 };
+
+  explicit TranspositionTable(size_t megabytes);
+
+  /* Reallocate the table at a new size, losing every entry. */
+  void resize(size_t megabytes);
+
+  void clear();
+
+  /* Start a new search, ageing every entry stored so far. */
+  void newSearch();
+
+  auto probe(zobrist::Key key) const -> std::optional<TTEntry>;
+
+  /*
+   * Store the result of a search of the position. The score must fit in 16 bits. A move of 0
+   * keeps the move already stored for the position, if any.
+   */
+  void store(zobrist::Key key, int depth, int score, Bound bound, Move move);
+
+  /* Start loading the cluster of a position into the cache, ahead of probing it. */
+  void prefetch(zobrist::Key key) const
+  {
+    __builtin_prefetch(&m_clusters[key & m_mask]);
+  }
+
+  /* Permille of a sample of entries used by the current search. */
+  auto hashfull() const -> int;
+
+  auto size() const -> size_t { return (m_mask + 1) * ENTRIES_PER_CLUSTER; }
+  auto pageMode() const -> memory::PageMode { return m_buffer.pageMode(); }
+
+private:
+  struct Entry
+  {
+    std::atomic<uint64_t> m_check{ 0 };
+    std::atomic<uint64_t> m_data{ 0 };
+  };
+
+  struct alignas(memory::CACHE_LINE_SIZE) Cluster
+  {
+    Entry m_entries[ENTRIES_PER_CLUSTER];
+  };
+
+  static_assert(sizeof(Cluster) == memory::CACHE_LINE_SIZE);
+
+  // Layout of the data word, from the bottom: move, score, depth, bound, age
+  static constexpr int SCORE_SHIFT{ 16 };
+  static constexpr int DEPTH_SHIFT{ 32 };
+  static constexpr int BOUND_SHIFT{ 40 };
+  static constexpr int AGE_SHIFT{ 42 };
+  static constexpr uint8_t AGE_MASK{ 0x3F };
+
+  static auto unpack(uint64_t data) -> TTEntry;
+  static auto age(uint64_t data) -> uint8_t { return (data >> AGE_SHIFT) & AGE_MASK; }
+
+  memory::LargeBuffer m_buffer;
+  Cluster* m_clusters{ nullptr };
+  size_t m_mask{ 0 };
+  uint8_t m_age{ 0 };
+};
+
+} // namespace yak::engine
@@ -0,0 +1,170 @@
+#include <catch2/catch_test_macros.hpp>
+
+#include <board.h>
+#include <move.hpp>
+#include <MovePicker.h>
+#include <SearchStack.h>
+
+#include <algorithm>
+#include <string>
+#include <vector>
+
+namespace yak::engine {
+
+namespace {
+
+// White can take the queen with the pawn or the knight, and the pawn on a7 with the rook
+static constexpr auto CAPTURES_FEN{ "4k3/p7/8/3q4/4P3/2N5/8/R3K3 w - - 0 1" };
+
+auto findMove(const std::vector<Move>& moves, const std::string& from, const std::string& to) -> Move
+{
+  const auto found = std::find_if(moves.begin(), moves.end(), [&](Move move) {
+    return toAlgebraic(static_cast<Square>(yak::from(move))) == from && toAlgebraic(static_cast<Square>(yak::to(move))) == to;
+  });
+  REQUIRE(found != moves.end());
+  return *found;
+}
+
+auto pickAll(MovePicker& picker) -> std::vector<Move>
+{
+  std::vector<Move> picked;
+  Move move;
+  while (picker.next(move))
+  {
+    picked.push_back(move);
+  }
+  return picked;
+}
+
+} // namespace
+
+TEST_CASE("Moves are picked hash move first, then captures by MVV-LVA")
+{
+  Board board{ CAPTURES_FEN };
+  auto moves = board.generateMoves();
+  const auto generated = moves;
+
+  const Move pawnTakesQueen = findMove(generated, "e4", "d5");
+  const Move knightTakesQueen = findMove(generated, "c3", "d5");
+  const Move rookTakesPawn = findMove(generated, "a1", "a7");
+  const Move hashMove = findMove(generated, "e1", "f2");
+
+  CHECK(mvvLva(pawnTakesQueen) > mvvLva(knightTakesQueen));
+  CHECK(mvvLva(knightTakesQueen) > mvvLva(rookTakesPawn));
+  CHECK(mvvLva(hashMove) == 0);
+
+  MovePicker picker{ board, moves, packMove(hashMove) };
+  const auto picked = pickAll(picker);
+
+  // Every move exactly once
+  REQUIRE(picked.size() == generated.size());
+  CHECK(std::is_permutation(picked.begin(), picked.end(), generated.begin()));
+
+  CHECK(picked[0] == hashMove);
+  CHECK(picked[1] == pawnTakesQueen);
+  CHECK(picked[2] == knightTakesQueen);
+  CHECK(picked[3] == rookTakesPawn);
+}
+
+TEST_CASE("Captures that lose material are picked last")
+{
+  // The pawn on e6 is defended, the one on a5 isn't
+  Board board{ "4k3/3p4/4p3/p7/8/8/8/4QK2 w - - 0 1" };
+  auto moves = board.generateMoves();
+  const auto generated = moves;
+
+  MovePicker picker{ board, moves, 0 };
+  const auto picked = pickAll(picker);
+  REQUIRE(picked.size() == generated.size());
+
+  CHECK(picked.front() == findMove(generated, "e1", "a5"));
+  CHECK(picked.back() == findMove(generated, "e1", "e6"));
+}
+
+TEST_CASE("Quiet moves are picked killers first, then the counter move, then by history")
+{
+  Board board{ CAPTURES_FEN };
+  const auto generated = board.generateMoves();
+
+  const Move kingMove = findMove(generated, "e1", "f2");
+  const Move rookMove = findMove(generated, "a1", "a5");
+  const Move knightMove = findMove(generated, "c3", "b5");
+  const Move pawnMove = findMove(generated, "e4", "e5");
+  const Move otherKnightMove = findMove(generated, "c3", "a4");
+
+  Board black{ "4k3/p7/8/3q4/4P3/2N5/8/R3K3 b - - 0 1" };
+  const Move previous = findMove(black.generateMoves(), "a7", "a6");
+
+  MoveHistory history;
+  PlyState state;
+
+  // The knight move cuts off after the king move failed: it becomes a killer, and only the king
+  // move loses history
+  const std::vector<Move> first{ kingMove, knightMove };
+  history.update(PieceColour::WHITE, 4, Move{}, first);
+  state.addKiller(knightMove);
+  CHECK(state.m_killers[0] == knightMove);
+  CHECK(history.history(PieceColour::WHITE, knightMove) > 0);
+  CHECK(history.history(PieceColour::WHITE, kingMove) < 0);
+  CHECK(history.history(PieceColour::BLACK, knightMove) == 0);
+
+  // Then the rook move, twice, which pushes the knight move down to the second killer only once,
+  // and becomes the counter to previous
+  const std::vector<Move> second{ rookMove };
+  history.update(PieceColour::WHITE, 2, previous, second);
+  state.addKiller(rookMove);
+  state.addKiller(rookMove);
+  CHECK(state.m_killers[0] == rookMove);
+  CHECK(state.m_killers[1] == knightMove);
+  CHECK(history.counterMove(PieceColour::WHITE, previous) == rookMove);
+
+  // A pawn move cuts off at another ply, so it is only the counter and has history
+  const std::vector<Move> third{ pawnMove };
+  history.update(PieceColour::WHITE, 6, previous, third);
+  CHECK(history.history(PieceColour::WHITE, pawnMove) > history.history(PieceColour::WHITE, knightMove));
+
+  const std::vector<Move> fourth{ otherKnightMove };
+  history.update(PieceColour::WHITE, 1, Move{}, fourth);
+
+  auto moves = generated;
+  MovePicker picker{ board, moves, 0, history, PieceColour::WHITE, state.m_killers, previous };
+  const auto picked = pickAll(picker);
+  REQUIRE(picked.size() == generated.size());
+
+  // After the three captures
+  CHECK(picked[3] == rookMove);
+  CHECK(picked[4] == knightMove);
+  CHECK(picked[5] == pawnMove);
+  CHECK(picked[6] == otherKnightMove);
+
+  // The king move, with a history below every untried move, comes last
+  CHECK(picked.back() == kingMove);
+
+  history.clear();
+  CHECK(history.history(PieceColour::WHITE, pawnMove) == 0);
+  CHECK(history.counterMove(PieceColour::WHITE, previous) == Move{});
+}
+
+TEST_CASE("History scores stay within their limit")
+{
+  Board board{ CAPTURES_FEN };
+  const auto generated = board.generateMoves();
+
+  const Move good = findMove(generated, "e1", "f2");
+  const Move bad = findMove(generated, "a1", "a5");
+
+  MoveHistory history;
+  const std::vector<Move> tried{ bad, good };
+
+  for (int i = 0; i < 10000; ++i)
+  {
+    history.update(PieceColour::WHITE, 20, Move{}, tried);
+  }
+
+  CHECK(history.history(PieceColour::WHITE, good) > MoveHistory::MAX_HISTORY / 2);
+  CHECK(history.history(PieceColour::WHITE, good) <= MoveHistory::MAX_HISTORY);
+  CHECK(history.history(PieceColour::WHITE, bad) < -MoveHistory::MAX_HISTORY / 2);
+  CHECK(history.history(PieceColour::WHITE, bad) >= -MoveHistory::MAX_HISTORY);
+}
+
+} // namespace yak::engine
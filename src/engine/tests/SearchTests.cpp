@@ -0,0 +1,501 @@
+#include <catch2/catch_test_macros.hpp>
+
+#include <board.h>
+#include <AlphaBeta.h>
+#include <Search.h>
+#include <TranspositionTable.h>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <iostream>
+#include <stdexcept>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+namespace yak::engine {
+
+namespace {
+
+bool isLegal(Board& board, Move move)
+{
+  const auto moves = board.generateMoves();
+  return std::find(moves.begin(), moves.end(), move) != moves.end();
+}
+
+/* A context without a table that searches with SearchOptions::exact(). */
+auto exactContext() -> SearchContext
+{
+  SearchContext context{ nullptr };
+  context.setOptions(SearchOptions::exact());
+  return context;
+}
+
+/*
+ * Plain negamax, to check the scores of the search against. Leaves are scored by quiescence, with
+ * its mates moved out to the ply of the leaf.
+ */
+int negamax(Board& board, int depth, int ply = 0)
+{
+  if (depth == 0)
+  {
+    auto context = exactContext();
+    const int score = alphaBeta(board, -INFINITE_SCORE, INFINITE_SCORE, 0, context).first;
+
+    if (score >= MATE_BOUND) return score - ply;
+    if (score <= -MATE_BOUND) return score + ply;
+    return score;
+  }
+
+  const auto moves = board.generateMoves();
+  if (moves.empty()) return board.isCheck() ? matedIn(ply) : DRAW_SCORE;
+
+  int best = -INFINITE_SCORE;
+  for (const auto& move : moves)
+  {
+    board.makeMove(move);
+    const int score = -negamax(board, depth - 1, ply + 1);
+    board.undoMove();
+
+    best = std::max(best, score);
+  }
+
+  return best;
+}
+
+} // namespace
+
+TEST_CASE("Quiescence resolves captures at the horizon")
+{
+  SECTION("Quiet positions stand pat")
+  {
+    Board board{ "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1" };
+    CHECK(alphaBeta(board, -INFINITE_SCORE, INFINITE_SCORE, 0).first == evaluate(board));
+  }
+
+  SECTION("A defended pawn is not worth the queen")
+  {
+    Board board{ "4k3/8/4p3/3p4/8/8/8/3QK3 w - - 0 1" };
+    const auto [score, move] = alphaBeta(board, -INFINITE_SCORE, INFINITE_SCORE, 1);
+
+    CHECK(toAlgebraic(move) != "d1d5");
+    CHECK(score > 0);
+  }
+
+  SECTION("A hanging queen is taken")
+  {
+    Board board{ "4k3/8/8/3q4/8/8/8/3QK3 w - - 0 1" };
+    CHECK(alphaBeta(board, -INFINITE_SCORE, INFINITE_SCORE, 0).first > evaluate(board) + 5);
+  }
+
+  SECTION("Checks are evaded, and mates found")
+  {
+    Board board{ "4k3/8/8/8/8/8/5PPP/r5K1 w - - 0 1" };
+    CHECK(alphaBeta(board, -INFINITE_SCORE, INFINITE_SCORE, 0).first == matedIn(0));
+  }
+}
+
+TEST_CASE("Principal variation search scores positions as plain negamax")
+{
+  for (auto fen : { "r1bqkbnr/pppp1ppp/2n5/4p3/4P3/5N2/PPPP1PPP/RNBQKB1R w KQkq - 2 3",
+                    "r1bqkbnr/pppp1ppp/2n5/4p3/4P3/5N2/PPPP1PPP/RNBQKB1R b KQkq - 2 3",
+                    "8/2p5/3p4/KP5r/1R3p1k/8/4P1P1/8 w - - 0 1" })
+  {
+    Board board{ fen };
+    const int expected = negamax(board, 3);
+
+    auto context = exactContext();
+    CHECK(alphaBeta(board, -INFINITE_SCORE, INFINITE_SCORE, 3, context).first == expected);
+
+    // Windows that the score is outside of give bounds on the side it falls
+    context = exactContext();
+    CHECK(alphaBeta(board, expected + 1, expected + 10, 3, context).first <= expected + 1);
+
+    context = exactContext();
+    CHECK(alphaBeta(board, expected - 10, expected - 1, 3, context).first >= expected - 1);
+  }
+}
+
+TEST_CASE("Mates are scored by their distance from the root")
+{
+  // Qa8 and Qg7 mate at once, and many other moves mate later
+  static constexpr auto QUICK_FEN{ "7k/8/6K1/8/8/8/8/Q7 w - - 0 1" };
+
+  // Rd8+ Rxd8 Rxd8, and after Rd8+ black can only take
+  static constexpr auto BACK_RANK_FEN{ "2r3k1/5ppp/8/8/8/8/3R1PPP/3R2K1 w - - 0 1" };
+  static constexpr auto CHECKED_FEN{ "2rR2k1/5ppp/8/8/8/8/5PPP/3R2K1 b - - 1 1" };
+
+  SECTION("Without the table")
+  {
+    Board board{ QUICK_FEN };
+    auto context = exactContext();
+    const auto [score, move] = alphaBeta(board, -INFINITE_SCORE, INFINITE_SCORE, 5, context);
+    CHECK(score == mateIn(1));
+    CHECK(context.principalVariation().size() == 1);
+
+    board.makeMove(move);
+    CHECK((board.isCheck() && board.generateMoves().empty()));
+
+    board.reset(BACK_RANK_FEN);
+    context = exactContext();
+    CHECK(alphaBeta(board, -INFINITE_SCORE, INFINITE_SCORE, 5, context).first == mateIn(3));
+    CHECK(context.principalVariation().size() == 3);
+
+    board.reset(CHECKED_FEN);
+    context = exactContext();
+    CHECK(alphaBeta(board, -INFINITE_SCORE, INFINITE_SCORE, 5, context).first == matedIn(2));
+  }
+
+  SECTION("With the table, which keeps mates relative to the position")
+  {
+    TranspositionTable table{ 4 };
+
+    Board board{ QUICK_FEN };
+    CHECK(alphaBeta(board, 5, PieceColour::WHITE, table).first == mateIn(1));
+
+    board.reset(BACK_RANK_FEN);
+    const auto [score, move] = alphaBeta(board, 5, PieceColour::WHITE, table);
+    CHECK(score == mateIn(3));
+    CHECK(toAlgebraic(move) == "d2d8");
+
+    // The table now holds the position after Rd8+ as mated in two from there
+    board.makeMove(move);
+    CHECK(alphaBeta(board, 5, PieceColour::BLACK, table).first == matedIn(2));
+  }
+}
+
+TEST_CASE("An excluded move is left out of the search and its result out of the table")
+{
+  // The knight forks the king and queen
+  Board board{ "2q3k1/8/8/3N4/8/8/1P6/6K1 w - - 0 1" };
+  TranspositionTable table{ 1 };
+
+  SearchContext context{ &table };
+  context.setOptions(SearchOptions::exact());
+  const auto [score, move] = alphaBeta(board, -INFINITE_SCORE, INFINITE_SCORE, 4, context);
+  REQUIRE(toAlgebraic(move) == "d5e7");
+
+  table.clear();
+
+  SearchContext excluding{ &table };
+  excluding.setOptions(SearchOptions::exact());
+  excluding.stack()[0].m_excludedMove = move;
+  const auto [otherScore, otherMove] = alphaBeta(board, -INFINITE_SCORE, INFINITE_SCORE, 4, excluding);
+
+  CHECK(otherMove != move);
+  CHECK(isLegal(board, otherMove));
+  CHECK(otherScore < score);
+
+  // The position without one of its moves isn't the position
+  CHECK_FALSE(table.probe(board.hash()));
+}
+
+TEST_CASE("Aspiration windows find the score of the full window")
+{
+  // Deep enough for the later iterations to use aspiration windows
+  Board board{ "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1" };
+  auto context = exactContext();
+  const int expected = alphaBeta(board, -INFINITE_SCORE, INFINITE_SCORE, 5, context).first;
+
+  TranspositionTable table{ 4 };
+  std::atomic<bool> stop{ false };
+
+  SearchLimits limits{};
+  limits.m_depth = 5;
+
+  const auto result = search(board, limits, table, stop, {}, SearchOptions::exact());
+  CHECK(result.m_depth == 5);
+  CHECK(result.m_score == expected);
+}
+
+TEST_CASE("Forward pruning searches fewer nodes and still finds tactics")
+{
+  const auto searchWith = [](std::string_view fen, int depth, const SearchOptions& options) {
+    Board board{ fen };
+    TranspositionTable table{ 4 };
+    std::atomic<bool> stop{ false };
+
+    SearchLimits limits{};
+    limits.m_depth = depth;
+    return search(board, limits, table, stop, {}, options);
+  };
+
+  // Each technique alone, then all of them
+  for (auto option : { &SearchOptions::m_nullMove,
+                       &SearchOptions::m_lateMoveReductions,
+                       &SearchOptions::m_reverseFutility,
+                       &SearchOptions::m_futility,
+                       &SearchOptions::m_razoring,
+                       static_cast<bool SearchOptions::*>(nullptr) })
+  {
+    SearchOptions options = SearchOptions::exact();
+    if (option) options.*option = true;
+    else options = SearchOptions{};
+
+    // The knight forks the king and queen
+    const auto fork = searchWith("2q3k1/8/8/3N4/8/8/1P6/6K1 w - - 0 1", 4, options);
+    CHECK(toAlgebraic(fork.m_bestMove) == "d5e7");
+    CHECK(fork.m_score > pieceValue(PieceType::QUEEN) / 2);
+
+    // A back rank mate in two
+    const auto mate = searchWith("2r3k1/5ppp/8/8/8/8/3R1PPP/3R2K1 w - - 0 1", 4, options);
+    CHECK(toAlgebraic(mate.m_bestMove) == "d2d8");
+    CHECK(mate.m_score == mateIn(3));
+  }
+
+  const auto kiwipete = "r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq - 0 1";
+  const auto pruned = searchWith(kiwipete, 5, SearchOptions{});
+  const auto unpruned = searchWith(kiwipete, 5, SearchOptions::exact());
+  CHECK(pruned.m_nodes * 2 < unpruned.m_nodes);
+}
+
+TEST_CASE("Search deepens one iteration at a time up to the depth limit")
+{
+  Board board{ "r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq - 0 1" };
+  TranspositionTable table{ 4 };
+  std::atomic<bool> stop{ false };
+
+  SearchLimits limits{};
+  limits.m_depth = 3;
+
+  std::vector<int> depths;
+  const auto result = search(board, limits, table, stop, [&depths](const SearchResult& iteration) { depths.push_back(iteration.m_depth); });
+
+  CHECK(depths == std::vector<int>{ 1, 2, 3 });
+  CHECK(result.m_depth == 3);
+  CHECK(result.m_nodes > 0);
+  CHECK(isLegal(board, result.m_bestMove));
+}
+
+TEST_CASE("Search reports the principal variation of each iteration")
+{
+  Board board{ "r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq - 0 1" };
+  TranspositionTable table{ 4 };
+  std::atomic<bool> stop{ false };
+
+  SearchLimits limits{};
+  limits.m_depth = 6;
+
+  std::vector<SearchResult> iterations;
+  search(board, limits, table, stop, [&iterations](const SearchResult& iteration) { iterations.push_back(iteration); });
+  REQUIRE(iterations.size() == 6);
+
+  for (const auto& iteration : iterations)
+  {
+    REQUIRE_FALSE(iteration.m_pv.empty());
+    CHECK(iteration.m_pv.front() == iteration.m_bestMove);
+    CHECK(iteration.m_pv.size() <= static_cast<size_t>(iteration.m_depth));
+
+    // Every move of the line is legal after the ones before it
+    size_t played{ 0 };
+    for (const auto& move : iteration.m_pv)
+    {
+      if (not isLegal(board, move)) break;
+      board.makeMove(move);
+      ++played;
+    }
+    CHECK(played == iteration.m_pv.size());
+
+    for (size_t i = 0; i < played; ++i)
+    {
+      board.undoMove();
+    }
+  }
+
+  CHECK(iterations.back().m_pv.size() > 1);
+}
+
+TEST_CASE("Search always completes the first iteration")
+{
+  Board board{ "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1" };
+  TranspositionTable table{ 1 };
+
+  SECTION("Already stopped")
+  {
+    std::atomic<bool> stop{ true };
+    const auto result = search(board, SearchLimits{}, table, stop);
+
+    CHECK(result.m_depth == 1);
+    CHECK(isLegal(board, result.m_bestMove));
+  }
+
+  SECTION("Node limit")
+  {
+    std::atomic<bool> stop{ false };
+    SearchLimits limits{};
+    limits.m_nodes = 1;
+
+    const auto result = search(board, limits, table, stop);
+
+    CHECK(result.m_depth == 1);
+    CHECK(isLegal(board, result.m_bestMove));
+  }
+}
+
+TEST_CASE("Search stops at its limits")
+{
+  Board board{ "r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq - 0 1" };
+  TranspositionTable table{ 4 };
+  std::atomic<bool> stop{ false };
+
+  SECTION("Nodes")
+  {
+    SearchLimits limits{};
+    limits.m_nodes = 20000;
+
+    const auto result = search(board, limits, table, stop);
+
+    // Checked exactly, once the first iteration is complete
+    CHECK(result.m_nodes <= 20000);
+    CHECK(isLegal(board, result.m_bestMove));
+  }
+
+  SECTION("Move time")
+  {
+    SearchLimits limits{};
+    limits.m_moveTime = std::chrono::milliseconds{ 50 };
+
+    const auto start = std::chrono::steady_clock::now();
+    const auto result = search(board, limits, table, stop);
+    const auto elapsed = std::chrono::steady_clock::now() - start;
+
+    CHECK(elapsed < std::chrono::milliseconds{ 500 });
+    CHECK(isLegal(board, result.m_bestMove));
+  }
+
+  SECTION("Clock")
+  {
+    SearchLimits limits{};
+    limits.m_blackTime = std::chrono::milliseconds{ 100 };
+    limits.m_whiteTime = std::chrono::milliseconds{ 3000 };
+    limits.m_whiteIncrement = std::chrono::milliseconds{ 100 };
+
+    const auto start = std::chrono::steady_clock::now();
+    const auto result = search(board, limits, table, stop);
+    const auto elapsed = std::chrono::steady_clock::now() - start;
+
+    // A budget of 3000 / 30 + 75 ms, and at most three times that for the last iteration
+    CHECK(elapsed < std::chrono::milliseconds{ 1000 });
+    CHECK(isLegal(board, result.m_bestMove));
+  }
+}
+
+TEST_CASE("Search stops deepening once it finds a mate")
+{
+  Board board{ "r1bqkbnr/pppp1ppp/2n5/4p3/2B1P3/5Q2/PPPP1PPP/RNB1K1NR w KQkq - 0 1" };
+  TranspositionTable table{ 1 };
+  std::atomic<bool> stop{ false };
+
+  const auto result = search(board, SearchLimits{}, table, stop);
+
+  CHECK(toAlgebraic(result.m_bestMove) == "f3f7");
+  CHECK(result.m_depth == 1);
+}
+
+TEST_CASE("Lazy SMP searches with helper threads")
+{
+  Board board{ "r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq - 0 1" };
+  TranspositionTable table{ 16 };
+  std::atomic<bool> stop{ false };
+
+  SearchOptions options{};
+  options.m_threads = 4;
+
+  SECTION("Depth")
+  {
+    SearchLimits limits{};
+    limits.m_depth = 6;
+
+    std::vector<uint64_t> nodes;
+    const auto result = search(board, limits, table, stop, [&nodes](const SearchResult& iteration) { nodes.push_back(iteration.m_nodes); }, options);
+
+    CHECK(result.m_depth == 6);
+    CHECK(isLegal(board, result.m_bestMove));
+    CHECK(std::is_sorted(nodes.begin(), nodes.end()));
+    CHECK(result.m_nodes >= nodes.back());
+    CHECK(board.toFen() == "r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq - 0 1");
+  }
+
+  SECTION("Move time")
+  {
+    SearchLimits limits{};
+    limits.m_moveTime = std::chrono::milliseconds{ 50 };
+
+    const auto start = std::chrono::steady_clock::now();
+    const auto result = search(board, limits, table, stop, {}, options);
+    const auto elapsed = std::chrono::steady_clock::now() - start;
+
+    // The helpers stop with the main thread
+    CHECK(elapsed < std::chrono::milliseconds{ 500 });
+    CHECK(isLegal(board, result.m_bestMove));
+  }
+
+  SECTION("A report that throws")
+  {
+    const auto start = std::chrono::steady_clock::now();
+    CHECK_THROWS_AS(search(board, SearchLimits{}, table, stop, [](const SearchResult&) { throw std::runtime_error{ "report" }; }, options),
+                    std::runtime_error);
+    const auto elapsed = std::chrono::steady_clock::now() - start;
+
+    // The helpers are stopped as the exception leaves the search, rather than going on to MAX_DEPTH
+    CHECK(elapsed < std::chrono::milliseconds{ 500 });
+  }
+
+  SECTION("Mate")
+  {
+    board.reset("2r3k1/5ppp/8/8/8/8/3R1PPP/3R2K1 w - - 0 1");
+    const auto result = search(board, SearchLimits{}, table, stop, {}, options);
+
+    CHECK(toAlgebraic(result.m_bestMove) == "d2d8");
+    CHECK(result.m_score == mateIn(3));
+  }
+}
+
+TEST_CASE("Lazy SMP speedup", "[benchmark]")
+{
+  // Time to depth over a few middlegame positions, for each number of threads up to one per
+  // hardware thread (and at least 16), each with an empty table
+  const std::vector<std::string_view> fens{
+    "r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq - 0 1",
+    "r4rk1/1pp1qppp/p1np1n2/2b1p1B1/2B1P1b1/P1NP1N2/1PP1QPPP/R4RK1 w - - 0 10",
+    "rnbq1k1r/pp1Pbppp/2p5/8/2B5/8/PPP1NnPP/RNBQK2R w KQ - 1 8",
+  };
+  const int depth{ 11 };
+
+  const size_t maxThreads = std::max<size_t>(16, std::thread::hardware_concurrency());
+
+  double singleThreaded{ 0.0 };
+  for (size_t threads = 1; threads <= maxThreads; threads *= 2)
+  {
+    SearchOptions options{};
+    options.m_threads = threads;
+
+    double seconds{ 0.0 };
+    uint64_t nodes{ 0 };
+
+    for (const auto fen : fens)
+    {
+      Board board{ fen };
+      TranspositionTable table{ 256 };
+      std::atomic<bool> stop{ false };
+
+      SearchLimits limits{};
+      limits.m_depth = depth;
+
+      const auto result = search(board, limits, table, stop, {}, options);
+      CHECK(result.m_depth == depth);
+      CHECK(isLegal(board, result.m_bestMove));
+
+      seconds += result.m_seconds;
+      nodes += result.m_nodes;
+    }
+
+    if (threads == 1) singleThreaded = seconds;
+
+    std::cout << threads << " threads: " << seconds << " s to depth " << depth << ", "
+              << static_cast<uint64_t>(nodes / seconds) << " nodes/s, speedup " << singleThreaded / seconds << std::endl;
+  }
+}
+
+} // namespace yak::engine
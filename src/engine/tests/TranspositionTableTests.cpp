@@ -0,0 +1,134 @@
+#include <catch2/catch_test_macros.hpp>
+
+#include <board.h>
+#include <AlphaBeta.h>
+#include <Search.h>
+#include <TranspositionTable.h>
+
+#include <algorithm>
+#include <set>
+
+namespace yak::engine {
+
+TEST_CASE("Packed moves tell every legal move apart")
+{
+  // Promotions of each piece, captures and castling on both sides
+  for (auto fen : { "r3k2r/1P6/8/8/8/8/6p1/R3K2R w KQkq - 0 1", "r3k2r/1P6/8/8/8/8/6p1/R3K2R b KQkq - 0 1" })
+  {
+    Board board{ fen };
+
+    std::set<PackedMove> packed;
+    for (const auto& move : board.generateMoves())
+    {
+      CHECK(packMove(move) != 0);
+      packed.insert(packMove(move));
+    }
+
+    CHECK(packed.size() == board.generateMoves().size());
+  }
+}
+
+TEST_CASE("Stored entries are found by their key")
+{
+  TranspositionTable table{ 1 };
+  CHECK(table.size() == 1024 * 1024 / 16);
+
+  Board board{ "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1" };
+  const Move move = board.generateMoves().front();
+
+  CHECK_FALSE(table.probe(12345));
+
+  table.store(12345, 7, -321, Bound::LOWER, move);
+
+  const auto entry = table.probe(12345);
+  REQUIRE(entry);
+  CHECK(entry->m_move == packMove(move));
+  CHECK(entry->m_score == -321);
+  CHECK(entry->m_depth == 7);
+  CHECK(entry->m_bound == Bound::LOWER);
+
+  CHECK_FALSE(table.probe(12346));
+
+  // Storing without a move keeps the move already known for the position
+  table.store(12345, 8, 50, Bound::EXACT, Move{});
+  CHECK(table.probe(12345)->m_move == packMove(move));
+  CHECK(table.probe(12345)->m_score == 50);
+
+  table.clear();
+  CHECK_FALSE(table.probe(12345));
+}
+
+TEST_CASE("Full clusters replace the least valuable entry")
+{
+  TranspositionTable table{ 1 };
+
+  // Keys that only differ above the index share a cluster
+  const zobrist::Key stride = zobrist::Key{ 1 } << 40;
+  for (int i = 0; i < 4; ++i)
+  {
+    table.store(99 + i * stride, 1 + i, i, Bound::EXACT, Move{});
+  }
+
+  for (int i = 0; i < 4; ++i)
+  {
+    CHECK(table.probe(99 + i * stride));
+  }
+
+  // The shallowest entry makes way
+  table.store(99 + 4 * stride, 3, 4, Bound::EXACT, Move{});
+  CHECK_FALSE(table.probe(99));
+  CHECK(table.probe(99 + 4 * stride));
+
+  // Entries of an earlier search make way for shallower ones of the current search, unless they
+  // are much deeper
+  table.newSearch();
+  CHECK(table.hashfull() == 0);
+
+  for (int i = 5; i < 9; ++i)
+  {
+    table.store(99 + i * stride, 1, i, Bound::EXACT, Move{});
+  }
+
+  for (int i = 1; i < 5; ++i)
+  {
+    CHECK_FALSE(table.probe(99 + i * stride));
+  }
+
+  // A shallower result of the same position from the same search doesn't replace a deeper one
+  table.store(99 + 5 * stride, 6, 55, Bound::LOWER, Move{});
+  table.store(99 + 5 * stride, 2, 66, Bound::LOWER, Move{});
+  CHECK(table.probe(99 + 5 * stride)->m_score == 55);
+}
+
+TEST_CASE("Searching with a table gives the same result")
+{
+  for (auto fen : { "r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq - 0 1",
+                    "8/2p5/3p4/KP5r/1R3p1k/8/4P1P1/8 w - - 0 1" })
+  {
+    Board board{ fen };
+    TranspositionTable table{ 4 };
+
+    // The forward pruning depends on the window and the move order, which the table changes, so
+    // results stored in the table under one window could change the score found under another
+    const SearchOptions options = SearchOptions::exact();
+
+    const auto searchWith = [&](TranspositionTable* table) {
+      SearchContext context{ table };
+      context.setOptions(options);
+      return alphaBeta(board, -INFINITE_SCORE, INFINITE_SCORE, 3, context).first;
+    };
+
+    const int expected = searchWith(nullptr);
+
+    // Once with an empty table, then again with the entries of the first search
+    CHECK(searchWith(&table) == expected);
+    table.newSearch();
+    CHECK(searchWith(&table) == expected);
+    CHECK(board.toFen() == fen);
+
+    // The default options still find a legal move
+    CHECK(alphaBeta(board, 3, PieceColour::WHITE, table).second != Move{});
+  }
+}
+
+} // namespace yak::engine
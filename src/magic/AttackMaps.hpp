@@ -13,42 +13,47 @@ namespace yak::attackmap {
 /* ------------------------------------------------------------------ */
 
 /**
- * \brief Metafunction for ray generation.
+ * \brief Ray cast by a sliding piece on an empty board.
  * \tparam D - Ray direction.
- * \tparam S - Square of the piece casting the ray.
+ * \param[in] square - Square of the piece casting the ray.
+ * \return Bitboard of all the squares on the ray, not including the square itself.
  */
-template<Direction D, Square S, Bitboard B = bitboard::shift<D>(Bitboard{1} << S)>
-struct Ray
+template<Direction D>
+constexpr auto ray(Square square) -> Bitboard
 {
-  static constexpr Bitboard value = B | Ray<D, S, bitboard::shift<D>(B)>::value;
-};
+  Bitboard ray_bb{ 0 };
 
-/**
- * \brief Base case specialisation when bitboard is equal to 0.
- * \tparam D - Ray direction.
- * \tparam S - Square of the piece casting the ray.
- */
-template<Direction D, Square S>
-struct Ray<D, S, 0>
+  for (Bitboard next = bitboard::shift<D>(Bitboard{1} << square); next; next = bitboard::shift<D>(next))
+  {
+    ray_bb |= next;
+  }
+
+  return ray_bb;
+}
+
+template<Direction D>
+consteval auto buildRayMap() -> std::array<Bitboard, 64>
 {
-  static constexpr Bitboard value{0};
-};
+  std::array<Bitboard, 64> map{};
+
+  for (int square = A1; square <= H8; ++square)
+  {
+    map[square] = ray<D>(static_cast<Square>(square));
+  }
+
+  return map;
+}
 
 /**
  * \brief Static table of sliding piece rays.
  * \tparam D - The direction of the ray.
  * \details
- * Usage: ray_map<Direction::NORTH>::value[42];
+ * Usage: RayMap<Direction::NORTH>::value[42];
  */
-template<Direction D, Square S = A1, Bitboard... B>
-struct RayMap : RayMap<D, static_cast<Square>(S + 1), B..., Ray<D, S>::value>
-{
-};
-
-template<Direction D, Bitboard... B>
-struct RayMap<D, static_cast<Square>(64), B...>
+template<Direction D>
+struct RayMap
 {
-  static constexpr std::array<Bitboard, 64> value = {B...};
+  static constexpr std::array<Bitboard, 64> value = buildRayMap<D>();
 };
 
 template<Direction D> struct IsPositiveRay : std::true_type {};
@@ -60,7 +65,7 @@ template<> struct IsPositiveRay<Direction::SOUTH_WEST> : std::false_type {};
 template<Direction D>
 constexpr auto blockedRay(Square square, Bitboard occupied) -> Bitboard
 {
-  constexpr std::array<Bitboard, 64> thisDirectionRayMap = RayMap<D>::value;
+  const std::array<Bitboard, 64>& thisDirectionRayMap = RayMap<D>::value;
 
   const Bitboard piecesInRay = thisDirectionRayMap[square] & occupied;
 
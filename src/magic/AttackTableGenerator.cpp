@@ -0,0 +1,51 @@
+#include "MagicTables.h"
+
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <vector>
+
+/*
+ * Writes the slider attack tables to a binary blob, which is mapped at startup when the tables are
+ * configured with YAK_ATTACK_TABLES=BLOB.
+ */
+int main(int argc, char* argv[])
+{
+  if (argc < 2)
+  {
+    std::cerr << "Usage: " << argv[0] << " <output_file>\n";
+    return 1;
+  }
+
+  auto tables = std::make_unique<yak::magic::SliderTables>();
+  yak::magic::fillSliderTables(*tables);
+
+  yak::magic::BlobHeader header{};
+  header.tag = yak::magic::BLOB_TAG;
+  header.version = yak::magic::BLOB_VERSION;
+  header.headerSize = sizeof(yak::magic::BlobHeader);
+  header.tablesOffset = yak::magic::BLOB_TABLES_OFFSET;
+  header.tablesSize = sizeof(yak::magic::SliderTables);
+  header.magicsChecksum = yak::magic::magicsChecksum();
+
+  std::vector<char> padding(yak::magic::BLOB_TABLES_OFFSET - sizeof(header), 0);
+
+  std::ofstream outputFile(argv[1], std::ios::binary);
+  if (!outputFile)
+  {
+    std::cerr << "Error: Could not open file for writing!\n";
+    return 1;
+  }
+
+  outputFile.write(reinterpret_cast<const char*>(&header), sizeof(header));
+  outputFile.write(padding.data(), padding.size());
+  outputFile.write(reinterpret_cast<const char*>(tables.get()), sizeof(yak::magic::SliderTables));
+
+  if (!outputFile)
+  {
+    std::cerr << "Error: Could not write attack tables!\n";
+    return 1;
+  }
+
+  return 0;
+}
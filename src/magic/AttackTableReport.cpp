@@ -0,0 +1,116 @@
+#include "MagicTables.h"
+
+#include <bitboard.h>
+
+#include <chrono>
+#include <cstdint>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <string_view>
+
+namespace {
+
+// Read a field in kB from one of the kernel's process status files.
+auto readKilobytes(const char* path, std::string_view field) -> long
+{
+  std::ifstream status{ path };
+  std::string line;
+
+  while (std::getline(status, line))
+  {
+    if (line.rfind(field, 0) == 0)
+    {
+      return std::stol(line.substr(field.size()));
+    }
+  }
+
+  return -1;
+}
+
+// Resident set size of this process in kB.
+auto residentKilobytes() -> long
+{
+  return readKilobytes("/proc/self/status", "VmRSS:");
+}
+
+// Amount of anonymous memory of this process that is backed by huge pages, in kB.
+auto hugePageKilobytes() -> long
+{
+  return readKilobytes("/proc/self/smaps_rollup", "AnonHugePages:");
+}
+
+} // namespace
+
+/*
+ * Reports how the slider attack tables were set up, and the cost of doing so: the time spent before
+ * main, and the resident size of the process before and after every table entry has been touched.
+ */
+int main()
+{
+  const long residentAtStart = residentKilobytes();
+
+  const auto start = std::chrono::steady_clock::now();
+
+  // Look up every entry of every table, by enumerating every blocker permutation of every square.
+  yak::Bitboard checksum{ 0 };
+  for (int square = yak::A1; square <= yak::H8; ++square)
+  {
+    const auto rookMask = yak::magic::OccupancyMasks<yak::PieceType::ROOK>::value[square];
+    yak::Bitboard blocker_bb{ 0 };
+    do
+    {
+      checksum ^= yak::magic::MagicBitboards<yak::PieceType::ROOK>(static_cast<yak::Square>(square), blocker_bb);
+      blocker_bb = (blocker_bb - rookMask) & rookMask;
+    }
+    while (blocker_bb);
+
+    const auto bishopMask = yak::magic::OccupancyMasks<yak::PieceType::BISHOP>::value[square];
+    do
+    {
+      checksum ^= yak::magic::MagicBitboards<yak::PieceType::BISHOP>(static_cast<yak::Square>(square), blocker_bb);
+      blocker_bb = (blocker_bb - bishopMask) & bishopMask;
+    }
+    while (blocker_bb);
+  }
+
+  const auto elapsed = std::chrono::steady_clock::now() - start;
+  const long residentAfterTouch = residentKilobytes();
+
+  // Random lookups, which is the access pattern of move generation and the one that suffers from
+  // TLB misses.
+  constexpr int RANDOM_LOOKUPS = 10'000'000;
+  uint64_t state{ 0x9e3779b97f4a7c15ULL };
+
+  const auto randomStart = std::chrono::steady_clock::now();
+  for (int lookup = 0; lookup < RANDOM_LOOKUPS; ++lookup)
+  {
+    state ^= state >> 12;
+    state ^= state << 25;
+    state ^= state >> 27;
+    const auto random = state * 0x2545f4914f6cdd1dULL;
+
+    const auto square = static_cast<yak::Square>(random & 63);
+    checksum ^= (random & 64)
+      ? yak::magic::MagicBitboards<yak::PieceType::ROOK>(square, random)
+      : yak::magic::MagicBitboards<yak::PieceType::BISHOP>(square, random);
+  }
+  const auto randomElapsed = std::chrono::steady_clock::now() - randomStart;
+
+  const auto info = yak::magic::attackTableInfo();
+
+  std::cout << "Attack table mode:      " << yak::magic::toString(info.mode) << " (" << info.source << ")\n";
+  std::cout << "Table size:             " << info.bytes / 1024 << " kB\n";
+  std::cout << "Initialisation:         " << info.initMicroseconds << " us\n";
+  std::cout << "Pages:                  " << yak::memory::toString(info.pages) << "\n";
+  std::cout << "Huge page support:      " << yak::memory::hugePageSupport().reason << "\n";
+  std::cout << "Resident at main:       " << residentAtStart << " kB\n";
+  std::cout << "Resident after touch:   " << residentAfterTouch << " kB\n";
+  std::cout << "Huge pages in use:      " << hugePageKilobytes() << " kB\n";
+  std::cout << "Touch all entries:      " << std::chrono::duration<double, std::micro>(elapsed).count() << " us\n";
+  std::cout << "Random lookups:         "
+            << std::chrono::duration<double, std::nano>(randomElapsed).count() / RANDOM_LOOKUPS << " ns each\n";
+  std::cout << "Checksum:               0x" << std::hex << checksum << std::dec << "\n";
+
+  return 0;
+}
@@ -3,7 +3,9 @@
 #include <types.h>
 #include "MagicCommon.h"
 #include <GeneratedMagics.h>
+#include <algorithm>
 #include <array>
+#include <utility>
 
 namespace yak::magic {
 
@@ -30,52 +32,153 @@ template<>
 struct Magics<PieceType::ROOK>
 {
   static constexpr std::array<Bitboard, 64> value = ROOK_MAGICS;
+  static constexpr std::array<int, 64> bits = ROOK_INDEX_BITS;
 };
 
 template<>
 struct Magics<PieceType::BISHOP>
 {
   static constexpr std::array<Bitboard, 64> value = BISHOP_MAGICS;
+  static constexpr std::array<int, 64> bits = BISHOP_INDEX_BITS;
 };
 
-template<PieceType Type, Square S>
-consteval auto buildMagicMap() -> std::array<Bitboard, MAX_PERMUTATIONS>
+/*
+ * Number of bits used to index the attack table of a square. This is normally the same as the
+ * number of bits in the occupancy mask, but can be smaller when the generator has found a magic
+ * with constructive collisions.
+ */
+template<PieceType Type>
+constexpr auto indexBits(Square square)
 {
-  std::array<Bitboard, MAX_PERMUTATIONS> map{};
+  return Magics<Type>::bits[square];
+}
 
-  auto magic = Magics<Type>::value[S];
+/*
+ * Size of the attack table for each square, this only needs to be large enough for the square
+ * with the most index bits.
+ */
+template<PieceType Type>
+static constexpr int TableSize = (1 << *std::max_element(Magics<Type>::bits.begin(), Magics<Type>::bits.end()));
 
-  for (int i = 0; i < numberOfPermutations<Type>(S); ++i)
+template<PieceType Type>
+using AttackTable = std::array<Bitboard, TableSize<Type>>;
+
+/*
+ * Fill the attack table of a single square, by calculating the attacks for every permutation of
+ * the blockers in the occupancy mask.
+ *
+ * The order in which the permutations are visited doesn't matter, so rather than calculating each
+ * one with maskPermutation, they are enumerated with the carry-rippler trick, which is much cheaper
+ * to evaluate at compile time.
+ */
+template<PieceType Type>
+constexpr void fillMagicMap(AttackTable<Type>& map, Square square)
+{
+  const auto magic = Magics<Type>::value[square];
+  const auto mask = OccupancyMasks<Type>::value[square];
+
+  Bitboard blocker_bb{ 0 };
+
+  do
   {
-    auto blocker_bb = maskPermutation(OccupancyMasks<Type>::value[S], i);
     auto index = transform(blocker_bb,
                            magic,
-                           numberOfBits<Type>(S));
-    map[index] = singleSquareAttack<Type>(static_cast<int>(S), blocker_bb);
+                           indexBits<Type>(square));
+    map[index] = singleSquareAttack<Type>(static_cast<int>(square), blocker_bb);
+    blocker_bb = (blocker_bb - mask) & mask;
   }
+  while (blocker_bb);
+}
 
-  return map;
+/*
+ * The attack tables for both slider types, this is the layout used by the runtime and binary blob
+ * table modes (and by the blob file itself).
+ */
+struct alignas(64) SliderTables
+{
+  std::array<AttackTable<PieceType::ROOK>, 64> rook;
+  std::array<AttackTable<PieceType::BISHOP>, 64> bishop;
+};
+
+inline void fillSliderTables(SliderTables& tables)
+{
+  for (int square = A1; square <= H8; ++square)
+  {
+    fillMagicMap<PieceType::ROOK>(tables.rook[square], static_cast<Square>(square));
+    fillMagicMap<PieceType::BISHOP>(tables.bishop[square], static_cast<Square>(square));
+  }
 }
 
-template<PieceType Type, Square S, std::array<Bitboard, MAX_PERMUTATIONS>... B>
-struct MagicMapImpl : MagicMapImpl<Type, static_cast<Square>(S + 1), B..., buildMagicMap<Type, S>()> {};
+#if defined(YAK_ATTACK_TABLES_RUNTIME) || defined(YAK_ATTACK_TABLES_BLOB)
+
+/*
+ * The attack tables are not part of the executable, they are set up (see MagicTables.cpp) either by
+ * filling them at startup or by mapping a blob written by the build. sliderTables is null until
+ * then, as it is constant initialised, so a lookup made by the static initialiser of another file
+ * before the tables are set up sets them up itself.
+ */
+extern const SliderTables* sliderTables;
+
+/* Set up the tables if they aren't already, and return them. */
+auto initialisedSliderTables() -> const SliderTables*;
 
-template<PieceType Type, std::array<Bitboard, MAX_PERMUTATIONS>... B>
-struct MagicMapImpl<Type, H8, B...>
+template<PieceType Type>
+inline auto MagicBitboards(Square square, Bitboard blocker_bb) -> Bitboard
 {
-  static constexpr std::array<std::array<Bitboard, MAX_PERMUTATIONS>, 64> value { B..., buildMagicMap<Type, H8>() };
-};
+  const auto mask = OccupancyMasks<Type>::value[square];
+  const auto index = transform(blocker_bb & mask, Magics<Type>::value[square], indexBits<Type>(square));
+
+  const SliderTables* tables = sliderTables;
+  if (tables == nullptr) [[unlikely]] tables = initialisedSliderTables();
+
+  if constexpr (Type == PieceType::ROOK)
+  {
+    return tables->rook[square][index];
+  }
+  else
+  {
+    return tables->bishop[square][index];
+  }
+}
+
+#else
+
+template<PieceType Type>
+consteval auto buildMagicMap(Square square) -> AttackTable<Type>
+{
+  AttackTable<Type> map{};
+  fillMagicMap<Type>(map, square);
+  return map;
+}
+
+/*
+ * Build the attack tables of all squares.
+ *
+ * Each square's table is a separate immediate invocation of buildMagicMap, so each one is evaluated
+ * (and counted against the compiler's constexpr operation limit) on its own, while only a single
+ * instantiation of this function is needed per piece type.
+ */
+template<PieceType Type, std::size_t... Squares>
+constexpr auto buildMagicMaps(std::index_sequence<Squares...>) -> std::array<AttackTable<Type>, 64>
+{
+  return { buildMagicMap<Type>(static_cast<Square>(Squares))... };
+}
 
 template<PieceType Type>
-struct MagicMaps : MagicMapImpl<Type, A1> {};
+struct MagicMaps
+{
+  static constexpr std::array<AttackTable<Type>, 64> value = buildMagicMaps<Type>(std::make_index_sequence<64>{});
+};
 
 template<PieceType Type>
 constexpr auto MagicBitboards(Square square, Bitboard blocker_bb) -> Bitboard
 {
   const auto mask = OccupancyMasks<Type>::value[square];
-  const auto index = transform(blocker_bb & mask, Magics<Type>::value[square], numberOfBits<Type>(square));
+  const auto index = transform(blocker_bb & mask, Magics<Type>::value[square], indexBits<Type>(square));
 
   return MagicMaps<Type>::value[square][index];
 }
 
+#endif
+
 } // namespace yak::magic
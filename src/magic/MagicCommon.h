@@ -45,18 +45,28 @@ consteval auto occupancyMask(Square square) -> Bitboard
   return mask;
 }
 
+template<PieceType Type>
+consteval auto buildOccupancyMasks() -> std::array<Bitboard, 64>
+{
+  std::array<Bitboard, 64> masks{};
+
+  for (int square = A1; square <= H8; ++square)
+  {
+    masks[square] = occupancyMask<Type>(static_cast<Square>(square));
+  }
+
+  return masks;
+}
+
 /*
  * Occupancy Masks for all squares.
  *
  * Generates a compile-time static table of occupancy mask bitboards.
  */
-template<PieceType Type, Square S = A1, Bitboard ...Masks>
-struct OccupancyMasks : OccupancyMasks<Type, static_cast<Square>(static_cast<int>(S) + 1), Masks..., occupancyMask<Type>(S)> {};
-
-template<PieceType Type, Bitboard ...Masks>
-struct OccupancyMasks<Type, NULL_SQUARE, Masks...>
+template<PieceType Type>
+struct OccupancyMasks
 {
-  static constexpr std::array<Bitboard, 64> value = { Masks... };
+  static constexpr std::array<Bitboard, 64> value = buildOccupancyMasks<Type>();
 };
 
 constexpr auto transform(Bitboard board, Bitboard magic, int bits) -> int
@@ -1,21 +1,25 @@
 #include "MagicNumberGeneration.h"
 #include <types.h>
 
+#include <filesystem>
 #include <iomanip>
 #include <sstream>
 #include <iostream>
 #include <fstream>
+#include <string_view>
 
-std::string formatMagicArray(const std::array<yak::Bitboard, 64>& magics)
+namespace {
+
+std::string formatMagicArray(const std::array<yak::magic::generation::MagicEntry, 64>& magics)
 {
   std::stringstream ss;
 
   yak::Square square{ yak::A1 };
 
-  for (const auto& magic : magics)
+  for (const auto& entry : magics)
   {
     std::ostringstream hexStream;
-    hexStream << "0x" << std::hex << magic << ",";
+    hexStream << "0x" << std::hex << entry.magic << ",";
 
     std::ostringstream commentStream;
     commentStream << "// Magic for square " << yak::toAlgebraic(square);
@@ -28,47 +32,173 @@ std::string formatMagicArray(const std::array<yak::Bitboard, 64>& magics)
   return ss.str();
 }
 
+std::string formatBitsArray(const std::array<yak::magic::generation::MagicEntry, 64>& magics)
+{
+  std::stringstream ss;
+
+  for (int rank = 0; rank < 8; ++rank)
+  {
+    ss << " ";
+
+    for (int file = 0; file < 8; ++file)
+    {
+      ss << " " << std::setw(2) << magics[rank * 8 + file].bits << ",";
+    }
+
+    ss << "  // Rank " << (rank + 1) << "\n";
+  }
+
+  return ss.str();
+}
+
+bool copyFile(const std::filesystem::path& from, const std::filesystem::path& to)
+{
+  std::error_code error;
+  std::filesystem::copy_file(from, to, std::filesystem::copy_options::overwrite_existing, error);
+  return not error;
+}
+
+void printUsage(const char* name)
+{
+  std::cerr << "Usage: " << name << " <output_file> [options]\n\n";
+  std::cerr << "Options:\n";
+  std::cerr << "  --seed <n>             Seed for the magic number search (default 0x5eedc0ffee15a1ce)\n";
+  std::cerr << "  --threads <n>          Number of search threads (default: hardware concurrency)\n";
+  std::cerr << "  --reduce-bits <n>      Try to find magics with n fewer index bits than the occupancy mask\n";
+  std::cerr << "  --reduce-attempts <n>  Candidates to try per square before giving up on a reduced magic\n";
+  std::cerr << "  --cache-dir <dir>      Reuse (and store) generated headers in this directory\n";
+  std::cerr << "  --cache-key <key>      Key identifying the generator inputs in the cache\n";
+}
+
+} // namespace
 
 int main(int argc, char* argv[])
 {
   if (argc < 2)
   {
-    std::cerr << "Usage: " << argv[0] << " <output_file>\n";
+    printUsage(argv[0]);
     return 1;
   }
 
-  std::ofstream outputFile(argv[1]);
-  if (!outputFile)
+  const std::filesystem::path outputPath{ argv[1] };
+
+  yak::magic::generation::SearchOptions options;
+  options.threads = std::max(1U, std::thread::hardware_concurrency());
+
+  std::filesystem::path cacheDir;
+  std::string cacheKey;
+
+  try
   {
-    std::cerr << "Error: Could not open file for writing!\n";
+    for (int i = 2; i < argc; ++i)
+    {
+      const std::string_view arg{ argv[i] };
+
+      if (i + 1 >= argc)
+      {
+        printUsage(argv[0]);
+        return 1;
+      }
+
+      const std::string value{ argv[++i] };
+
+      if (arg == "--seed") options.seed = std::stoull(value, nullptr, 0);
+      else if (arg == "--threads") options.threads = static_cast<unsigned>(std::stoul(value));
+      else if (arg == "--reduce-bits") options.reduceBits = std::stoi(value);
+      else if (arg == "--reduce-attempts") options.reducedAttempts = std::stoull(value);
+      else if (arg == "--cache-dir") cacheDir = value;
+      else if (arg == "--cache-key") cacheKey = value;
+      else
+      {
+        printUsage(argv[0]);
+        return 1;
+      }
+    }
+  }
+  catch (std::exception& e)
+  {
+    std::cerr << "Error: Could not parse arguments (" << e.what() << ")\n";
+    return 1;
+  }
+
+  // An unchanged generator (same sources, seed and options) always produces the same magics, so a
+  // previously generated header can be reused instead of searching again.
+  std::filesystem::path cachedHeader;
+  if (not cacheDir.empty() && not cacheKey.empty())
+  {
+    cachedHeader = cacheDir / ("GeneratedMagics-" + cacheKey + ".h");
+
+    if (std::filesystem::exists(cachedHeader) && copyFile(cachedHeader, outputPath))
+    {
+      std::cout << "Using cached magics from " << cachedHeader.string() << "\n";
+      return 0;
+    }
+  }
+
+  auto rookMagics = yak::magic::generation::findAllMagics<yak::PieceType::ROOK>(options);
+  auto bishopMagics = yak::magic::generation::findAllMagics<yak::PieceType::BISHOP>(options);
+
+  if (not rookMagics || not bishopMagics)
+  {
+    std::cerr << "Error: Failed to find magic numbers for all squares!\n";
     return 1;
   }
 
   std::stringstream ss;
 
   ss << "#include <array>\n\n";
+  ss << "// Generated by MagicGenerator with seed 0x" << std::hex << options.seed << std::dec
+     << " and reduce-bits " << options.reduceBits << "\n\n";
   ss << "namespace yak::magic {\n";
 
   ss << "static constexpr std::array<Bitboard, 64> ROOK_MAGICS = { \n";
+  ss << formatMagicArray(*rookMagics);
+  ss << "};\n\n";
 
-  auto rookMagics = yak::magic::generation::findAllMagics<yak::PieceType::ROOK>();
-  ss << formatMagicArray(rookMagics);
-
+  ss << "static constexpr std::array<int, 64> ROOK_INDEX_BITS = { \n";
+  ss << formatBitsArray(*rookMagics);
   ss << "};\n\n";
 
   ss << "static constexpr std::array<Bitboard, 64> BISHOP_MAGICS = { \n";
+  ss << formatMagicArray(*bishopMagics);
+  ss << "};\n\n";
 
-  auto bishopMagics = yak::magic::generation::findAllMagics<yak::PieceType::BISHOP>();
-  ss << formatMagicArray(bishopMagics);
-
+  ss << "static constexpr std::array<int, 64> BISHOP_INDEX_BITS = { \n";
+  ss << formatBitsArray(*bishopMagics);
   ss << "};\n\n";
 
   ss << "} // namespace yak::magic\n";
   ss << "\n";
 
+  std::ofstream outputFile(outputPath);
+  if (!outputFile)
+  {
+    std::cerr << "Error: Could not open file for writing!\n";
+    return 1;
+  }
+
   outputFile << ss.str();
   outputFile.close();
 
+  if (not cachedHeader.empty())
+  {
+    // Write to a temporary file first so that a concurrent build never sees a partial header.
+    std::error_code error;
+    auto temporaryHeader = cachedHeader;
+    temporaryHeader += ".tmp";
+
+    std::filesystem::create_directories(cacheDir, error);
+
+    if (not error && copyFile(outputPath, temporaryHeader))
+    {
+      std::filesystem::rename(temporaryHeader, cachedHeader, error);
+    }
+
+    if (error || not std::filesystem::exists(cachedHeader))
+    {
+      std::cerr << "Warning: Could not write magics to cache " << cachedHeader.string() << "\n";
+    }
+  }
+
   return 0;
 }
-
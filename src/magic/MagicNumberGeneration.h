@@ -2,70 +2,187 @@
 
 #include <bitboard.h>
 #include "MagicCommon.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
 #include <optional>
+#include <thread>
+#include <vector>
 
 namespace yak::magic::generation {
 
-inline auto random_uint64() -> Bitboard
+/*
+ * Seeded pseudo random number generator for the magic search (xorshift64*).
+ *
+ * Every square is searched with its own generator, seeded from the global seed and the square, so
+ * the magics that are found do not depend on how the squares are scheduled across threads.
+ */
+class Random
 {
-  Bitboard u1, u2, u3, u4;
-  u1 = (Bitboard)(rand()) & 0xFFFF; u2 = (Bitboard)(rand()) & 0xFFFF;
-  u3 = (Bitboard)(rand()) & 0xFFFF; u4 = (Bitboard)(rand()) & 0xFFFF;
-  return u1 | (u2 << 16) | (u3 << 32) | (u4 << 48);
-}
+public:
+  explicit Random(uint64_t seed)
+    : m_state(splitMix(seed))
+  {
+    if (m_state == 0) m_state = 0x9E3779B97F4A7C15ULL;
+  }
+
+  auto next() -> uint64_t
+  {
+    m_state ^= m_state >> 12;
+    m_state ^= m_state << 25;
+    m_state ^= m_state >> 27;
+    return m_state * 0x2545F4914F6CDD1DULL;
+  }
+
+  // Magic numbers with few set bits are much more likely to work.
+  auto sparse() -> Bitboard
+  {
+    return next() & next() & next();
+  }
+
+private:
+  static auto splitMix(uint64_t value) -> uint64_t
+  {
+    value += 0x9E3779B97F4A7C15ULL;
+    value = (value ^ (value >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    value = (value ^ (value >> 27)) * 0x94D049BB133111EBULL;
+    return value ^ (value >> 31);
+  }
+
+  uint64_t m_state;
+};
 
-inline auto randomBitboard() -> Bitboard
+struct MagicEntry
 {
-  return random_uint64() & random_uint64() & random_uint64();
-}
+  Bitboard magic{ 0 };
+  int bits{ 0 };
+};
+
+struct SearchOptions
+{
+  uint64_t seed{ 0x5EED'C0FF'EE15'A1CEULL };
+  unsigned threads{ 1 };
+
+  // Number of index bits to try to remove from each square, compared with the number of bits in
+  // the occupancy mask. Squares for which no reduced magic is found within the attempt budget
+  // fall back to the full number of bits.
+  int reduceBits{ 0 };
+  uint64_t reducedAttempts{ 4'000'000 };
+};
 
+/*
+ * The blocker and attack permutations for a single square, these only need to be calculated once
+ * per square and are then reused for every candidate magic.
+ */
 template<PieceType Type>
-constexpr auto findMagic(Square square) -> std::optional<Bitboard>
+struct SquarePermutations
 {
-  std::array<Bitboard, MAX_PERMUTATIONS> blockerPermutations;
-  std::array<Bitboard, MAX_PERMUTATIONS> attackPermutations;
+  explicit SquarePermutations(Square square)
+    : mask(OccupancyMasks<Type>::value[square]),
+      maskBits(bitboard::countSetBits(mask)),
+      count(1 << maskBits)
+  {
+    for (int i = 0; i < count; ++i)
+    {
+      blockers[i] = maskPermutation(mask, i);
+      attacks[i] = singleSquareAttack<Type>(static_cast<int>(square), blockers[i]);
+    }
+  }
+
+  Bitboard mask;
+  int maskBits;
+  int count;
+  std::array<Bitboard, MAX_PERMUTATIONS> blockers;
+  std::array<Bitboard, MAX_PERMUTATIONS> attacks;
+};
+
+/*
+ * Scratch space for testing candidate magics.
+ *
+ * Rather than clearing the used table for every attempt, each slot is tagged with the attempt that
+ * last wrote to it, a slot written by an earlier attempt is treated as empty.
+ */
+struct CollisionTable
+{
+  std::array<uint16_t, MAX_PERMUTATIONS> indices;
+  std::array<uint32_t, MAX_PERMUTATIONS> epoch{};
   std::array<Bitboard, MAX_PERMUTATIONS> used;
+  uint32_t attempt{ 0 };
+};
+
+/*
+ * Test a candidate magic against all permutations of a square.
+ *
+ * The indices are calculated a block at a time in a branch free loop that the compiler can
+ * vectorise, the (inherently serial) collision check is then done for the block against the epoch
+ * tagged table. Most candidates collide within the first few permutations, so working in blocks
+ * avoids calculating thousands of indices for a magic that has already failed.
+ */
+template<PieceType Type>
+auto testMagic(const SquarePermutations<Type>& permutations,
+               CollisionTable& table,
+               Bitboard magic,
+               int bits) -> bool
+{
+  static constexpr int BLOCK_SIZE = 64;
 
-  const auto mask = OccupancyMasks<Type>::value[square];
-  const int numBits = bitboard::countSetBits(mask);
-  const int numPermutations = (1 << numBits);
+  const int count = permutations.count;
+  const int shift = 64 - bits;
 
-  for (int i = 0; i < numPermutations; ++i)
+  if (++table.attempt == 0)
   {
-    blockerPermutations[i] = maskPermutation(mask, i);
-    attackPermutations[i] = singleSquareAttack<Type>(static_cast<int>(square), blockerPermutations[i]);
+    std::fill(table.epoch.begin(), table.epoch.end(), 0);
+    table.attempt = 1;
   }
 
-  // Brute force search for a magic number that can work
-  for (int attempt = 0; attempt < 1000000000; ++attempt)
+  for (int block = 0; block < count; block += BLOCK_SIZE)
   {
-    Bitboard magic = randomBitboard();
+    const int blockEnd = std::min(block + BLOCK_SIZE, count);
 
-    // Not enough bits, this magic number will not work
-    if (bitboard::countSetBits((mask * magic) & 0xFF00000000000000ULL) < 6)
+    for (int i = block; i < blockEnd; ++i)
     {
-      continue;
+      table.indices[i] = static_cast<uint16_t>((permutations.blockers[i] * magic) >> shift);
     }
 
-    std::fill(used.begin(), used.end(), Bitboard{0ULL});
-    bool failure{false};
-
-    for (int i = 0; not failure && i < numPermutations; ++i)
+    for (int i = block; i < blockEnd; ++i)
     {
-      // TODO (haigh) vectorise this
-      int mapIndex = transform(blockerPermutations[i], magic, numBits);
+      const auto mapIndex = table.indices[i];
 
-      if (used[mapIndex] == Bitboard{0ULL})
+      if (table.epoch[mapIndex] != table.attempt)
       {
-        used[mapIndex] = attackPermutations[i];
+        table.epoch[mapIndex] = table.attempt;
+        table.used[mapIndex] = permutations.attacks[i];
       }
-      else if (used[mapIndex] != attackPermutations[i])
+      else if (table.used[mapIndex] != permutations.attacks[i])
       {
-        failure = true;
+        return false;
       }
     }
+  }
+
+  return true;
+}
+
+template<PieceType Type>
+auto findMagic(const SquarePermutations<Type>& permutations,
+               CollisionTable& table,
+               Random& random,
+               int bits,
+               uint64_t maxAttempts) -> std::optional<Bitboard>
+{
+  // Brute force search for a magic number that can work
+  for (uint64_t attempt = 0; attempt < maxAttempts; ++attempt)
+  {
+    Bitboard magic = random.sparse();
+
+    // Not enough bits, this magic number will not work
+    if (bitboard::countSetBits((permutations.mask * magic) & 0xFF00000000000000ULL) < 6)
+    {
+      continue;
+    }
 
-    if (not failure)
+    if (testMagic(permutations, table, magic, bits))
     {
       return magic;
     }
@@ -75,21 +192,75 @@ constexpr auto findMagic(Square square) -> std::optional<Bitboard>
 }
 
 template<PieceType Type>
-constexpr auto findAllMagics() -> std::array<Bitboard, 64>
+auto findMagic(Square square, const SearchOptions& options) -> std::optional<MagicEntry>
 {
-  std::array<Bitboard, 64> allMagics;
+  const SquarePermutations<Type> permutations{ square };
+  CollisionTable table;
 
-  for (int square = 0; square < 64; ++square)
+  // Salt the seed by piece type so that rooks and bishops do not share a random sequence.
+  const uint64_t salt = (Type == PieceType::ROOK) ? 0x52 : 0x42;
+  Random random{ options.seed ^ (salt << 56) ^ (static_cast<uint64_t>(square) * 0x9E3779B97F4A7C15ULL) };
+
+  const int reducedBits = permutations.maskBits - options.reduceBits;
+
+  if (options.reduceBits > 0 && reducedBits > 0)
   {
-    if (auto magic = findMagic<Type>(static_cast<Square>(square)))
+    if (auto magic = findMagic(permutations, table, random, reducedBits, options.reducedAttempts))
     {
-      allMagics[square] = *magic;
-      continue;
+      return MagicEntry{ *magic, reducedBits };
+    }
+  }
+
+  if (auto magic = findMagic(permutations, table, random, permutations.maskBits, 1'000'000'000))
+  {
+    return MagicEntry{ *magic, permutations.maskBits };
+  }
+
+  return {};
+}
+
+/*
+ * Search for the magics of all squares, the squares are shared out between a pool of worker threads
+ * which pick up the next unsearched square until all have been found.
+ */
+template<PieceType Type>
+auto findAllMagics(const SearchOptions& options) -> std::optional<std::array<MagicEntry, 64>>
+{
+  std::array<MagicEntry, 64> allMagics{};
+  std::atomic<int> nextSquare{ 0 };
+  std::atomic<bool> failed{ false };
+
+  auto worker = [&]
+  {
+    for (int square = nextSquare++; square < 64; square = nextSquare++)
+    {
+      if (auto entry = findMagic<Type>(static_cast<Square>(square), options))
+      {
+        allMagics[square] = *entry;
+        continue;
+      }
+
+      failed = true;
     }
+  };
+
+  const unsigned numThreads = std::clamp(options.threads, 1U, 64U);
+  std::vector<std::thread> threads;
 
-    /* throw std::runtime_error{"Failed to find magic bitboard for square " + toAlgebraic(static_cast<Square>(square))}; */
+  for (unsigned i = 1; i < numThreads; ++i)
+  {
+    threads.emplace_back(worker);
   }
 
+  worker();
+
+  for (auto& thread : threads)
+  {
+    thread.join();
+  }
+
+  if (failed) return {};
+
   return allMagics;
 }
 
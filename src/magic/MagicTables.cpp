@@ -0,0 +1,144 @@
+#include "MagicTables.h"
+
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <new>
+
+#if defined(YAK_ATTACK_TABLES_BLOB)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace yak::magic {
+
+namespace {
+
+AttackTableInfo g_info{ TableMode::CONSTEXPR, "executable", 0.0, sizeof(SliderTables), memory::PageMode::NORMAL_PAGES };
+
+#if defined(YAK_ATTACK_TABLES_BLOB)
+
+auto mapBlob(const char* path) -> const SliderTables*
+{
+  int fd = ::open(path, O_RDONLY);
+  if (fd < 0) return nullptr;
+
+  struct stat fileStat{};
+  const bool validSize = (::fstat(fd, &fileStat) == 0)
+    && (static_cast<uint64_t>(fileStat.st_size) == BLOB_TABLES_OFFSET + sizeof(SliderTables));
+
+  if (not validSize)
+  {
+    ::close(fd);
+    return nullptr;
+  }
+
+  void* mapping = ::mmap(nullptr, fileStat.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+  ::close(fd);
+
+  if (mapping == MAP_FAILED) return nullptr;
+
+  BlobHeader header;
+  std::memcpy(&header, mapping, sizeof(header));
+
+  const bool valid = header.tag == BLOB_TAG
+    && header.version == BLOB_VERSION
+    && header.headerSize == sizeof(BlobHeader)
+    && header.tablesOffset == BLOB_TABLES_OFFSET
+    && header.tablesSize == sizeof(SliderTables)
+    && header.magicsChecksum == magicsChecksum();
+
+  if (not valid)
+  {
+    ::munmap(mapping, fileStat.st_size);
+    return nullptr;
+  }
+
+  return reinterpret_cast<const SliderTables*>(static_cast<const char*>(mapping) + BLOB_TABLES_OFFSET);
+}
+
+#endif
+
+#if defined(YAK_ATTACK_TABLES_RUNTIME) || defined(YAK_ATTACK_TABLES_BLOB)
+
+auto initialiseTables() -> const SliderTables*
+{
+  const auto start = std::chrono::steady_clock::now();
+  const SliderTables* tables{ nullptr };
+
+#if defined(YAK_ATTACK_TABLES_BLOB)
+  g_info.mode = TableMode::BLOB;
+
+  // The location of the blob can be overridden at runtime, for example when the executable has been
+  // moved away from the build directory.
+  const char* path = std::getenv("YAK_ATTACK_TABLES_BLOB");
+  if (path == nullptr) path = YAK_ATTACK_TABLES_BLOB_PATH;
+
+  tables = mapBlob(path);
+  g_info.source = tables ? "mapped blob" : "filled at startup (blob unavailable)";
+#else
+  g_info.mode = TableMode::RUNTIME;
+  g_info.source = "filled at startup";
+#endif
+
+  if (tables == nullptr)
+  {
+    // Slider lookups are scattered across the whole of the tables, so back them with huge pages
+    // where possible to save on TLB misses. The tables live for the rest of the process.
+    static memory::LargeBuffer buffer{ sizeof(SliderTables) };
+
+    auto* filled = new (buffer.data()) SliderTables;
+    fillSliderTables(*filled);
+    tables = filled;
+    g_info.pages = buffer.pageMode();
+  }
+
+  const auto elapsed = std::chrono::steady_clock::now() - start;
+  g_info.initMicroseconds = std::chrono::duration<double, std::micro>(elapsed).count();
+
+  return tables;
+}
+
+#endif
+
+} // namespace
+
+#if defined(YAK_ATTACK_TABLES_RUNTIME) || defined(YAK_ATTACK_TABLES_BLOB)
+constinit const SliderTables* sliderTables{ nullptr };
+
+auto initialisedSliderTables() -> const SliderTables*
+{
+  // Set up once, however many static initialisers ask for the tables first
+  static const SliderTables* const tables = initialiseTables();
+  sliderTables = tables;
+  return tables;
+}
+
+namespace {
+
+// Set the tables up before main, so that lookups made after it never have to
+[[maybe_unused]] const SliderTables* const startupTables = initialisedSliderTables();
+
+} // namespace
+#endif
+
+auto attackTableInfo() -> AttackTableInfo
+{
+  return g_info;
+}
+
+auto toString(TableMode mode) -> std::string_view
+{
+  switch (mode)
+  {
+    case TableMode::CONSTEXPR: return "constexpr";
+    case TableMode::RUNTIME: return "runtime";
+    case TableMode::BLOB: return "blob";
+  }
+
+  return "unknown";
+}
+
+} // namespace yak::magic
@@ -0,0 +1,89 @@
+#pragma once
+
+#include "MagicBitboards.hpp"
+
+#include <LargeBuffer.h>
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+
+namespace yak::magic {
+
+/*
+ * Where the slider attack tables live, selected at configure time with YAK_ATTACK_TABLES.
+ *
+ * CONSTEXPR - built at compile time and stored in the executable (the default).
+ * RUNTIME   - filled in a heap allocation before main.
+ * BLOB      - written to a file by the build and mapped read only before main, falling back to
+ *             RUNTIME if the file is missing or doesn't match the compiled magics.
+ */
+enum class TableMode
+{
+  CONSTEXPR,
+  RUNTIME,
+  BLOB,
+};
+
+struct AttackTableInfo
+{
+  TableMode mode{ TableMode::CONSTEXPR };
+  const char* source{ "executable" };
+  double initMicroseconds{ 0.0 };
+  std::size_t bytes{ 0 };
+  memory::PageMode pages{ memory::PageMode::NORMAL_PAGES };
+};
+
+/*
+ * Report how the attack tables were set up, how long it took, and how they are paged. Only the
+ * tables filled at startup can be backed with huge pages, the others are file backed.
+ */
+auto attackTableInfo() -> AttackTableInfo;
+
+auto toString(TableMode mode) -> std::string_view;
+
+/*
+ * Binary blob layout: a BlobHeader, followed by a SliderTables at tablesOffset (page aligned so the
+ * tables can be used directly from the mapping).
+ */
+static constexpr std::array<char, 8> BLOB_TAG{ 'Y', 'A', 'K', 'A', 'T', 'T', 'K', '1' };
+static constexpr uint32_t BLOB_VERSION{ 1 };
+static constexpr uint64_t BLOB_TABLES_OFFSET{ 4096 };
+
+struct BlobHeader
+{
+  std::array<char, 8> tag;
+  uint32_t version;
+  uint32_t headerSize;
+  uint64_t tablesOffset;
+  uint64_t tablesSize;
+  uint64_t magicsChecksum;
+};
+
+/*
+ * Checksum of the compiled magics and index bits, a blob generated for different magics must not
+ * be used.
+ */
+constexpr auto magicsChecksum() -> uint64_t
+{
+  uint64_t hash{ 0xcbf29ce484222325ULL };
+
+  auto mix = [&hash](uint64_t value)
+  {
+    hash ^= value;
+    hash *= 0x100000001b3ULL;
+  };
+
+  for (int square = A1; square <= H8; ++square)
+  {
+    mix(Magics<PieceType::ROOK>::value[square]);
+    mix(static_cast<uint64_t>(Magics<PieceType::ROOK>::bits[square]));
+    mix(Magics<PieceType::BISHOP>::value[square]);
+    mix(static_cast<uint64_t>(Magics<PieceType::BISHOP>::bits[square]));
+  }
+
+  return hash;
+}
+
+} // namespace yak::magic
@@ -5,6 +5,14 @@
 
 namespace yak::magic {
 
+namespace {
+
+// Looked up by a static initialiser, which can run before the one that sets up the attack tables
+// when they aren't part of the executable
+const Bitboard startupRookAttacks = MagicBitboards<PieceType::ROOK>(A1, bitboard::EMPTY);
+
+} // namespace
+
 TEST_CASE("Compile time occupancy mask generation")
 {
   Bitboard mask{ bitboard::EMPTY };
@@ -141,4 +149,9 @@ TEST_CASE("Magic generation")
   }
 }
 
+TEST_CASE("Attacks can be looked up during static initialisation")
+{
+  CHECK(startupRookAttacks == bitboard::static_bitboard<A2, A3, A4, A5, A6, A7, A8, B1, C1, D1, E1, F1, G1, H1>::value);
+}
+
 } // namespace yak::magic
@@ -1,8 +1,15 @@
 #include "Perft.h"
+#include "PerftCheckpoint.h"
+#include "PerftHashTable.h"
 
 #include <board.h>
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <deque>
 #include <memory>
 #include <iostream>
+#include <optional>
 #include <types.h>
 
 namespace yak {
@@ -50,76 +57,486 @@ ThreadPool::~ThreadPool()
   }
 }
 
-PerftResult perft(Board& board, int depth)
+ThreadPool& ThreadPool::shared(size_t numThreads)
 {
-  PerftResult result{};
+  static ThreadPool pool{ numThreads ? numThreads : std::max(1u, std::thread::hardware_concurrency()) };
+  return pool;
+}
 
-  auto threadPool_p = std::make_unique<ThreadPool>(std::thread::hardware_concurrency());
-  return perftHelper(board, depth, std::move(threadPool_p));
+PerftProgress::PerftProgress(size_t workers)
+  : m_busy(workers)
+  , m_busySince(workers)
+{
 }
 
-PerftResult perftHelper(Board& board, int depth, std::unique_ptr<ThreadPool> threadPool_p)
+auto PerftProgress::now() -> uint64_t
 {
-  PerftResult result{};
+  return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
 
-  std::vector<Move> moves = board.generateMoves();
+void PerftProgress::start(size_t units, uint64_t moves)
+{
+  m_nodes = 0;
+  m_unitsDone = 0;
+  m_units = units;
+  m_moves = moves;
+  m_movesDone = 0;
+  m_countedNodes = 0;
+  m_countedMoves = 0;
 
-  if (depth == 1)
+  for (size_t worker = 0; worker < m_busy.size(); ++worker)
+  {
+    m_busy[worker] = 0;
+    m_busySince[worker] = 0;
+  }
+
+  m_start = now();
+}
+
+void PerftProgress::unitStarted(size_t worker)
+{
+  if (worker < m_busySince.size()) m_busySince[worker] = now();
+}
+
+void PerftProgress::unitFinished(size_t worker, uint64_t moves, uint64_t nodes)
+{
+  if (worker < m_busySince.size())
   {
-    result.m_total = moves.size();
-    // TODO (haigh) use ranges?
-    for (const auto& move : moves)
+    m_busy[worker] += now() - m_busySince[worker];
+    m_busySince[worker] = 0;
+  }
+
+  m_nodes += nodes;
+  m_movesDone += moves;
+  m_countedNodes += nodes;
+  m_countedMoves += moves;
+  ++m_unitsDone;
+}
+
+void PerftProgress::unitSkipped(uint64_t moves, uint64_t nodes)
+{
+  m_nodes += nodes;
+  m_movesDone += moves;
+  ++m_unitsDone;
+}
+
+auto PerftProgress::snapshot() const -> Snapshot
+{
+  Snapshot snapshot{};
+
+  const uint64_t start = m_start;
+  if (start == 0) return snapshot;
+
+  const uint64_t time = now();
+  const double elapsed = static_cast<double>(time - start);
+
+  snapshot.m_seconds = elapsed / 1e9;
+  snapshot.m_nodes = m_nodes;
+  snapshot.m_unitsDone = m_unitsDone;
+  snapshot.m_units = m_units;
+
+  // The nodes per legal move of the counted units is the branching factor of the plies below the
+  // first, raised to the depth, and is the same for every unit however many moves it has
+  const uint64_t countedMoves = m_countedMoves;
+  if (countedMoves)
+  {
+    const double nodesPerMove = static_cast<double>(m_countedNodes) / countedMoves;
+    const uint64_t movesLeft = m_moves - std::min<uint64_t>(m_moves, m_movesDone);
+    snapshot.m_estimatedNodes = snapshot.m_nodes + static_cast<uint64_t>(nodesPerMove * movesLeft);
+  }
+
+  for (size_t worker = 0; worker < m_busy.size(); ++worker)
+  {
+    const uint64_t since = m_busySince[worker];
+    const uint64_t busy = m_busy[worker] + ((since && time > since) ? time - since : 0);
+    snapshot.m_utilisation.push_back(elapsed > 0.0 ? std::min(1.0, static_cast<double>(busy) / elapsed) : 0.0);
+  }
+
+  return snapshot;
+}
+
+namespace {
+
+/*
+ * A subtree to be counted by a worker, given as the moves that lead to it from the root position,
+ * and the index of the root move it belongs to.
+ */
+struct WorkUnit
+{
+  std::vector<Move> m_path;
+  size_t m_root{ 0 };
+
+  /* Legal moves of the position, to estimate the size of the unit before it is counted. */
+  uint64_t m_moves{ 0 };
+};
+
+/*
+ * The work units of one worker. The owner takes units from the back, and idle workers steal from
+ * the front.
+ */
+struct WorkQueue
+{
+  std::mutex m_mutex;
+  std::deque<size_t> m_units;
+};
+
+void splitTree(Board& board, int depth, std::vector<Move>& path, size_t root, std::vector<WorkUnit>& units)
+{
+  if (depth == 0)
+  {
+    units.push_back(WorkUnit{ path, root, static_cast<uint64_t>(board.countLegalMoves().m_total) });
+    return;
+  }
+
+  for (const auto& move : board.generateMoves())
+  {
+    board.makeMove(move);
+    path.push_back(move);
+    splitTree(board, depth - 1, path, root, units);
+    path.pop_back();
+    (void) board.undoMove();
+  }
+}
+
+auto takeUnit(std::vector<WorkQueue>& queues, size_t worker) -> std::optional<size_t>
+{
+  {
+    auto& own = queues[worker];
+    std::unique_lock<std::mutex> lock(own.m_mutex);
+    if (not own.m_units.empty())
     {
-      if (isCapture(move)) ++result.m_captures;
+      auto unit = own.m_units.back();
+      own.m_units.pop_back();
+      return unit;
     }
-    return result;
   }
 
-  std::vector<std::future<PerftResult>> futures;
+  // Nothing left of our own, so steal from the other workers, starting with the next one along.
+  for (size_t offset = 1; offset < queues.size(); ++offset)
+  {
+    auto& victim = queues[(worker + offset) % queues.size()];
+    std::unique_lock<std::mutex> lock(victim.m_mutex);
+    if (not victim.m_units.empty())
+    {
+      auto unit = victim.m_units.front();
+      victim.m_units.pop_front();
+      return unit;
+    }
+  }
 
-  if (threadPool_p)
+  // All of the units have been handed out, and no more are ever added.
+  return std::nullopt;
+}
+
+/*
+ * Count the units of one worker, returning the counts of each root move.
+ *
+ * Each thread keeps a board for the life of the process, which is reset to the root position once
+ * per call. Every unit is reached by playing its moves from the root.
+ */
+auto runWorker(const std::string& rootFen,
+               const std::vector<WorkUnit>& units,
+               std::vector<WorkQueue>& queues,
+               size_t worker,
+               size_t numRoots,
+               int remainingDepth,
+               PerftHashTable* table,
+               const PerftOptions& options) -> std::vector<PerftResult>
+{
+  thread_local Board localBoard;
+  localBoard.reset(rootFen);
+
+  std::vector<PerftResult> results(numRoots);
+
+  while (auto unit = takeUnit(queues, worker))
   {
-    auto currentFen = board.toFen();
+    const auto& workUnit = units[*unit];
 
-    for (const auto& move : moves)
+    for (const auto& move : workUnit.m_path)
     {
-      auto task = [move, depth, currentFen]
-      {
-        Board localBoard{ currentFen };
-        localBoard.makeMove(move);
-        auto result = perftHelper(localBoard, depth - 1, nullptr);
-        localBoard.undoMove();
-        return result;
-      };
-
-      futures.push_back(threadPool_p->enqueue(std::move(task)));
+      localBoard.makeMove(move);
+    }
+
+    if (options.m_progress) options.m_progress->unitStarted(worker);
+
+    PerftResult result{};
+    if (table)
+    {
+      result.m_total = perftHashed(localBoard, remainingDepth, *table);
+    }
+    else
+    {
+      result = perftHelper(localBoard, remainingDepth);
+    }
+
+    results[workUnit.m_root] += result;
+    if (options.m_checkpoint) options.m_checkpoint->record(workUnit.m_path, result);
+    if (options.m_progress) options.m_progress->unitFinished(worker, workUnit.m_moves, result.m_total);
+
+    for (size_t i = 0; i < workUnit.m_path.size(); ++i)
+    {
+      (void) localBoard.undoMove();
     }
   }
-  else
+
+  return results;
+}
+
+void checksumHelper(Board& board, int depth, int ply, PerftChecksum& checksum)
+{
+  const auto moves = board.generateMoves();
+
+  auto& moveCounts = checksum.m_moveCounts[ply];
+  if (moveCounts.size() <= moves.size()) moveCounts.resize(moves.size() + 1);
+  ++moveCounts[moves.size()];
+
+  for (const auto& move : moves)
   {
-    for (const auto& move : moves)
+    board.makeMove(move);
+
+    if (depth == 1)
     {
-      Board::MoveResult moveResult = board.makeMove(move);
+      ++checksum.m_nodes;
+      checksum.m_leafHashSum += board.hash();
+    }
+    else
+    {
+      checksumHelper(board, depth - 1, ply + 1, checksum);
+    }
 
-      PerftResult newResult = perftHelper(board, depth - 1, nullptr);
+    (void) board.undoMove();
+  }
+}
 
-      result.m_total += newResult.m_total;
-      result.m_captures += newResult.m_captures;
+/*
+ * The counts of a single move, as a leaf of the tree.
+ */
+auto leafResult(Board& board, Move move) -> PerftResult
+{
+  PerftResult result{};
+  result.m_total = 1;
+  result.m_captures = isCapture(move) ? 1 : 0;
+  result.m_ep = isEnPassant(move) ? 1 : 0;
+  result.m_castles = isCastle(move) ? 1 : 0;
+  result.m_promotions = isPromotion(move) ? 1 : 0;
 
-      (void) board.undoMove();
+  if (board.givesCheck(move))
+  {
+    result.m_checks = 1;
+
+    board.makeMove(move);
+    result.m_checkmates = board.hasLegalMoves() ? 0 : 1;
+    (void) board.undoMove();
+  }
+
+  return result;
+}
+
+} // namespace
+
+PerftResult perft(Board& board, int depth)
+{
+  return perft(board, depth, PerftOptions{});
+}
+
+PerftResult perft(Board& board, int depth, const PerftOptions& options)
+{
+  if (depth < 2)
+  {
+    return perftHelper(board, depth);
+  }
+
+  PerftResult result{};
+  for (const auto& [move, moveResult] : perftDivide(board, depth, options))
+  {
+    result += moveResult;
+  }
+
+  return result;
+}
+
+std::vector<std::pair<Move, PerftResult>> perftDivide(Board& board, int depth, const PerftOptions& options)
+{
+  const auto rootMoves = board.generateMoves();
+
+  std::vector<std::pair<Move, PerftResult>> divide;
+  divide.reserve(rootMoves.size());
+
+  for (const auto& move : rootMoves)
+  {
+    divide.emplace_back(move, leafResult(board, move));
+  }
+
+  if (depth < 2) return divide;
+
+  auto& threadPool = ThreadPool::shared();
+  const size_t numWorkers = options.m_threads ? options.m_threads : threadPool.size();
+  const int splitDepth = std::clamp(options.m_splitDepth, 1, depth - 1);
+
+  // The root moves are the first ply of the split
+  std::vector<WorkUnit> units;
+  std::vector<Move> path;
+  for (size_t root = 0; root < rootMoves.size(); ++root)
+  {
+    board.makeMove(rootMoves[root]);
+    path.push_back(rootMoves[root]);
+    splitTree(board, splitDepth - 1, path, root, units);
+    path.pop_back();
+    (void) board.undoMove();
+  }
+
+  for (auto& [move, result] : divide)
+  {
+    result = PerftResult{};
+  }
+
+  if (options.m_progress)
+  {
+    uint64_t moves{ 0 };
+    for (const auto& unit : units) moves += unit.m_moves;
+    options.m_progress->start(units.size(), moves);
+  }
+
+  // Units finished by an earlier run are taken from the checkpoint, the rest are dealt out
+  std::vector<WorkQueue> queues(numWorkers);
+  size_t queued{ 0 };
+  for (size_t unit = 0; unit < units.size(); ++unit)
+  {
+    if (options.m_checkpoint)
+    {
+      if (auto result = options.m_checkpoint->find(units[unit].m_path))
+      {
+        divide[units[unit].m_root].second += *result;
+        if (options.m_progress) options.m_progress->unitSkipped(units[unit].m_moves, result->m_total);
+        continue;
+      }
     }
+
+    queues[queued++ % numWorkers].m_units.push_back(unit);
   }
 
-  if (not threadPool_p) return result;
+  const auto rootFen = board.toFen();
+  const int remainingDepth = depth - splitDepth;
+
+  std::unique_ptr<PerftHashTable> table;
+  if (options.m_hashMegabytes)
+  {
+    table = std::make_unique<PerftHashTable>(options.m_hashMegabytes);
+  }
+
+  auto addResults = [&divide](const std::vector<PerftResult>& results)
+  {
+    for (size_t root = 0; root < results.size(); ++root)
+    {
+      divide[root].second += results[root];
+    }
+  };
+
+  // The first worker runs on the calling thread, which would otherwise be waiting.
+  std::vector<std::future<std::vector<PerftResult>>> futures;
+  for (size_t worker = 1; worker < numWorkers; ++worker)
+  {
+    futures.push_back(threadPool.enqueue([&, worker]
+    {
+      return runWorker(rootFen, units, queues, worker, rootMoves.size(), remainingDepth, table.get(), options);
+    }));
+  }
+
+  addResults(runWorker(rootFen, units, queues, 0, rootMoves.size(), remainingDepth, table.get(), options));
 
   for (auto& future : futures)
   {
-    auto newResult = future.get();
-    result.m_total += newResult.m_total;
-    result.m_captures += newResult.m_captures;
+    addResults(future.get());
+  }
+
+  return divide;
+}
+
+PerftResult perftHelper(Board& board, int depth)
+{
+  PerftResult result{};
+
+  // Leaves are counted without generating their moves. Only the moves that give check are made,
+  // to find out which of them are mates.
+  if (depth == 1)
+  {
+    std::array<Move, MAX_MOVES> checkingMoves;
+    const auto counts = board.countLegalMoves(checkingMoves.data());
+    result.m_total = counts.m_total;
+    result.m_captures = counts.m_captures;
+    result.m_ep = counts.m_ep;
+    result.m_castles = counts.m_castles;
+    result.m_promotions = counts.m_promotions;
+    result.m_checks = counts.m_checks;
+
+    for (int i = 0; i < counts.m_checks; ++i)
+    {
+      board.makeMove(checkingMoves[i]);
+      if (not board.hasLegalMoves()) ++result.m_checkmates;
+      (void) board.undoMove();
+    }
+
+    return result;
+  }
+
+  for (const auto& move : board.generateMoves())
+  {
+    board.makeMove(move);
+    result += perftHelper(board, depth - 1);
+    (void) board.undoMove();
   }
 
   return result;
 }
 
+uint64_t perftTotal(Board& board, int depth)
+{
+  if (depth == 1) return board.countLegalMoves().m_total;
+
+  uint64_t nodes{ 0 };
+  for (const auto& move : board.generateMoves())
+  {
+    board.makeMove(move);
+    nodes += perftTotal(board, depth - 1);
+    (void) board.undoMove();
+  }
+
+  return nodes;
+}
+
+uint64_t perftHashed(Board& board, int depth, PerftHashTable& table)
+{
+  if (depth == 1) return board.countLegalMoves().m_total;
+
+  const auto hash = board.hash();
+  if (auto nodes = table.probe(hash, depth)) return *nodes;
+
+  uint64_t nodes{ 0 };
+  for (const auto& move : board.generateMoves())
+  {
+    board.makeMove(move);
+    nodes += perftHashed(board, depth - 1, table);
+    (void) board.undoMove();
+  }
+
+  table.store(hash, depth, nodes);
+  return nodes;
+}
+
+PerftChecksum perftChecksum(Board& board, int depth)
+{
+  PerftChecksum checksum{};
+  checksum.m_moveCounts.resize(depth);
+
+  if (depth == 0)
+  {
+    checksum.m_nodes = 1;
+    checksum.m_leafHashSum = board.hash();
+    return checksum;
+  }
+
+  checksumHelper(board, depth, 0, checksum);
+  return checksum;
+}
+
 } // namespace yak
@@ -1,12 +1,21 @@
 #pragma once
 
+#include <atomic>
 #include <condition_variable>
 #include <cstddef>
+#include <cstdint>
+#include <functional>
 #include <future>
+#include <memory>
+#include <mutex>
 #include <queue>
+#include <thread>
+#include <utility>
 #include <vector>
 #include <type_traits>
 
+#include <types.h>
+
 namespace yak {
 
 class ThreadPool
@@ -18,16 +27,28 @@ public:
   ThreadPool(const ThreadPool&) = delete;
   ThreadPool& operator=(const ThreadPool&) = delete;
 
+  /*
+   * The process wide pool used by perft, created on first use and kept until exit so that threads
+   * (and the boards they keep, see perft) are reused across calls.
+   *
+   * The pool has numThreads threads, or one per hardware thread if numThreads is 0. Only the first
+   * call creates the pool, so to choose its size call this before any perft.
+   *
+   * Tasks run on the shared pool must not wait on other tasks in it.
+   */
+  static ThreadPool& shared(size_t numThreads = 0);
+
   template<typename Task>
   auto enqueue(Task&& task) -> std::future<typename std::invoke_result_t<Task>>;
 
+  size_t size() const { return m_threads.size(); }
+
 private:
   std::vector<std::thread> m_threads;
   std::queue<std::function<void()>> m_tasks;
   std::mutex m_mutex;
   std::condition_variable m_conditionVariable;
   bool m_stop{ false };
-  size_t m_numThreads{ 1 };
 };
 
 template<typename Task>
@@ -56,10 +77,154 @@ struct PerftResult {
   size_t m_promotions{0};
   size_t m_checks{0};
   size_t m_checkmates{0};
+
+  PerftResult& operator+=(const PerftResult& other)
+  {
+    m_total += other.m_total;
+    m_captures += other.m_captures;
+    m_ep += other.m_ep;
+    m_castles += other.m_castles;
+    m_promotions += other.m_promotions;
+    m_checks += other.m_checks;
+    m_checkmates += other.m_checkmates;
+    return *this;
+  }
+};
+
+class PerftCheckpoint;
+
+/*
+ * Counters of a running perft, updated by its workers and read from another thread to report on
+ * progress. The tree is split into work units (see PerftOptions::m_splitDepth), and nodes are added
+ * as each unit finishes.
+ */
+class PerftProgress
+{
+public:
+  /* Room for the given number of workers, which should be at least the number used by the perft. */
+  explicit PerftProgress(size_t workers);
+
+  struct Snapshot
+  {
+    double m_seconds{ 0.0 };
+    uint64_t m_nodes{ 0 };
+    size_t m_unitsDone{ 0 };
+    size_t m_units{ 0 };
+
+    /*
+     * Nodes of the whole tree, extrapolated from the branching of the finished units: each unit
+     * left is taken to have as many nodes per legal move of its position as the counted units have
+     * had so far. Units differ in size by orders of magnitude, and the small ones finish first, so
+     * the legal moves of a unit are a far better guide to its size than the average unit. 0 until a
+     * unit with legal moves has finished.
+     */
+    uint64_t m_estimatedNodes{ 0 };
+
+    /* Fraction of the time so far that each worker has spent counting. */
+    std::vector<double> m_utilisation;
+  };
+
+  auto snapshot() const -> Snapshot;
+
+  /* Units is the number of work units, and moves the sum of the legal moves of their positions. */
+  void start(size_t units, uint64_t moves);
+  void unitStarted(size_t worker);
+
+  /* Moves is the number of legal moves of the unit's position, and nodes its count. */
+  void unitFinished(size_t worker, uint64_t moves, uint64_t nodes);
+  void unitSkipped(uint64_t moves, uint64_t nodes);
+
+private:
+  static auto now() -> uint64_t;
+
+  std::atomic<uint64_t> m_start{ 0 };
+  std::atomic<uint64_t> m_nodes{ 0 };
+  std::atomic<size_t> m_unitsDone{ 0 };
+  std::atomic<size_t> m_units{ 0 };
+
+  /* Legal moves of the positions of every unit, and of the finished and skipped ones. */
+  std::atomic<uint64_t> m_moves{ 0 };
+  std::atomic<uint64_t> m_movesDone{ 0 };
+
+  /* Nodes and legal moves of the units that were counted, rather than skipped, for the estimate. */
+  std::atomic<uint64_t> m_countedNodes{ 0 };
+  std::atomic<uint64_t> m_countedMoves{ 0 };
+
+  /* Per worker, the nanoseconds spent on finished units and when the current unit started (0 if idle). */
+  std::vector<std::atomic<uint64_t>> m_busy;
+  std::vector<std::atomic<uint64_t>> m_busySince;
+};
+
+struct PerftOptions
+{
+  /* Number of workers, 0 to use every thread of the shared pool. */
+  size_t m_threads{ 0 };
+
+  /*
+   * Number of plies expanded on the calling thread to split the tree into work units. Deeper splits
+   * give more, smaller units, which balance better across workers at the cost of a little more
+   * work up front.
+   */
+  int m_splitDepth{ 2 };
+
+  /*
+   * Size of the transposition cache shared by the workers, in MB, or 0 for no cache. Only node
+   * counts are cached, so a hashed perft reports m_total and none of the other counters.
+   */
+  size_t m_hashMegabytes{ 0 };
+
+  /*
+   * Record of the finished work units, which are skipped and have their counts taken from it
+   * rather than being counted again, or null for none. See PerftCheckpoint.
+   */
+  PerftCheckpoint* m_checkpoint{ nullptr };
+
+  /* Counters to update as the perft runs, or null for none. */
+  PerftProgress* m_progress{ nullptr };
 };
 
 class Board;
 PerftResult perft(Board& board, int depth);
-PerftResult perftHelper(Board& board, int depth, std::unique_ptr<ThreadPool> threadPool);
+PerftResult perft(Board& board, int depth, const PerftOptions& options);
+
+/*
+ * Perft of each legal move from the current position, in move generation order. Every root move is
+ * counted at the same time, so this is as fast as a single perft of the same depth.
+ */
+std::vector<std::pair<Move, PerftResult>> perftDivide(Board& board, int depth, const PerftOptions& options = {});
+
+PerftResult perftHelper(Board& board, int depth);
+
+/*
+ * Only the number of leaves below the board, on the calling thread. The leaves are counted in bulk,
+ * without the checks and mates of perftHelper, so this is faster when the total is all that is needed.
+ */
+uint64_t perftTotal(Board& board, int depth);
+
+class PerftHashTable;
+uint64_t perftHashed(Board& board, int depth, PerftHashTable& table);
+
+/*
+ * A fingerprint of a perft tree that doesn't depend on the order moves are generated in, to compare
+ * move generators more closely than by their node counts, which can hide bugs that cancel out.
+ */
+struct PerftChecksum
+{
+  uint64_t m_nodes{ 0 };
+
+  /* Sum of the Zobrist hashes of the leaf positions, wrapping on overflow. */
+  uint64_t m_leafHashSum{ 0 };
+
+  /* m_moveCounts[ply][n] is the number of positions ply moves from the root with n legal moves. */
+  std::vector<std::vector<uint64_t>> m_moveCounts;
+
+  bool operator==(const PerftChecksum& other) const = default;
+};
+
+/*
+ * The checksum of the tree below the board, counted on the calling thread. Every leaf is made to
+ * hash it, so this is much slower than perft.
+ */
+PerftChecksum perftChecksum(Board& board, int depth);
 
 } // namespace yak
@@ -0,0 +1,137 @@
+#include "PerftCheckpoint.h"
+
+#include <iterator>
+#include <sstream>
+
+namespace yak {
+
+namespace {
+
+constexpr std::string_view HEADER{ "yak-perft-checkpoint 2" };
+
+// Ends every unit line, so that a line cut short when the process was killed can't be mistaken for
+// a unit with smaller counts.
+constexpr std::string_view END_OF_UNIT{ ";" };
+
+} // namespace
+
+auto PerftCheckpoint::open(const std::string& path, std::string_view fen, int depth, bool totalsOnly, std::string& error)
+  -> std::unique_ptr<PerftCheckpoint>
+{
+  std::unique_ptr<PerftCheckpoint> checkpoint{ new PerftCheckpoint };
+
+  const std::string fenLine = "fen " + std::string{ fen };
+  const std::string depthLine = "depth " + std::to_string(depth);
+  const std::string countsLine = totalsOnly ? "counts totals" : "counts all";
+
+  std::string contents;
+  {
+    std::ifstream existing{ path };
+    contents.assign(std::istreambuf_iterator<char>{ existing }, std::istreambuf_iterator<char>{});
+  }
+
+  if (contents.empty())
+  {
+    checkpoint->m_file.open(path, std::ios::out | std::ios::trunc);
+    checkpoint->m_file << HEADER << "\n" << fenLine << "\n" << depthLine << "\n" << countsLine << "\n" << std::flush;
+  }
+  else
+  {
+    std::istringstream lines{ contents };
+    std::string header, fenRead, depthRead, countsRead;
+    std::getline(lines, header);
+    std::getline(lines, fenRead);
+    std::getline(lines, depthRead);
+    std::getline(lines, countsRead);
+
+    if (header != HEADER)
+    {
+      error = "not a perft checkpoint: " + path;
+      return nullptr;
+    }
+
+    if (fenRead != fenLine || depthRead != depthLine)
+    {
+      error = "checkpoint " + path + " is of a different run (" + fenRead.substr(fenRead.find(' ') + 1) + ", "
+        + depthRead + ")";
+      return nullptr;
+    }
+
+    // The units of a hashed run have only their totals, which can't stand in for full counts
+    if (countsRead != countsLine)
+    {
+      error = "checkpoint " + path + (totalsOnly ? " counts more than the totals, so can't be resumed with --hash"
+                                                 : " counts only the totals, so can only be resumed with --hash");
+      return nullptr;
+    }
+
+    std::string line;
+    while (std::getline(lines, line))
+    {
+      std::istringstream fields{ line };
+
+      std::string key, end;
+      PerftResult result{};
+      fields >> key >> result.m_total >> result.m_captures >> result.m_ep >> result.m_castles >> result.m_promotions
+        >> result.m_checks >> result.m_checkmates >> end;
+
+      if (fields && end == END_OF_UNIT) checkpoint->m_units[key] = result;
+    }
+
+    checkpoint->m_file.open(path, std::ios::out | std::ios::app);
+
+    // Finish off a line cut short, so the next unit starts on a line of its own
+    if (contents.back() != '\n') checkpoint->m_file << "\n" << std::flush;
+  }
+
+  if (not checkpoint->m_file)
+  {
+    error = "could not write checkpoint " + path;
+    return nullptr;
+  }
+
+  return checkpoint;
+}
+
+auto PerftCheckpoint::find(const std::vector<Move>& path) const -> std::optional<PerftResult>
+{
+  std::unique_lock<std::mutex> lock(m_mutex);
+
+  auto unit = m_units.find(key(path));
+  if (unit == m_units.end()) return std::nullopt;
+
+  return unit->second;
+}
+
+void PerftCheckpoint::record(const std::vector<Move>& path, const PerftResult& result)
+{
+  const auto unitKey = key(path);
+
+  std::ostringstream line;
+  line << unitKey << " " << result.m_total << " " << result.m_captures << " " << result.m_ep << " " << result.m_castles
+       << " " << result.m_promotions << " " << result.m_checks << " " << result.m_checkmates << " " << END_OF_UNIT << "\n";
+
+  std::unique_lock<std::mutex> lock(m_mutex);
+  m_units[unitKey] = result;
+  m_file << line.str() << std::flush;
+}
+
+auto PerftCheckpoint::size() const -> size_t
+{
+  std::unique_lock<std::mutex> lock(m_mutex);
+  return m_units.size();
+}
+
+auto PerftCheckpoint::key(const std::vector<Move>& path) -> std::string
+{
+  // Moves are written as their encoded value, as castling moves have no from and to squares
+  std::string key;
+  for (const auto& move : path)
+  {
+    if (not key.empty()) key += '-';
+    key += std::to_string(move);
+  }
+  return key;
+}
+
+} // namespace yak
@@ -0,0 +1,61 @@
+#pragma once
+
+#include "Perft.h"
+
+#include <fstream>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include <types.h>
+
+namespace yak {
+
+/*
+ * A record of the work units of a perft that have been counted, kept in a file so that a run that
+ * is stopped part of the way through can be restarted without counting them again.
+ *
+ * The file starts with the position and depth of the run, and whether it counts only the totals
+ * (as a hashed perft does), followed by a line for each finished unit: the moves from the root to
+ * the unit and its counts. Lines are appended and flushed as the units finish, so at most the units
+ * being counted are lost when the process is killed, and a line cut short by the kill is ignored
+ * when the file is loaded.
+ *
+ * Units are found by their moves, so a run restarted with a different split depth finds none of
+ * the earlier units and starts again from scratch.
+ */
+class PerftCheckpoint
+{
+public:
+  /*
+   * Open the checkpoint at path, creating it if it doesn't exist. Returns nullptr, and sets error,
+   * if the file can't be written or is a checkpoint of a different position or depth, or one that
+   * counts only the totals when totalsOnly isn't set, or the other way round.
+   */
+  static auto open(const std::string& path, std::string_view fen, int depth, bool totalsOnly, std::string& error)
+    -> std::unique_ptr<PerftCheckpoint>;
+
+  /* The counts of a unit finished by an earlier run. */
+  auto find(const std::vector<Move>& path) const -> std::optional<PerftResult>;
+
+  /* Record a finished unit, safe to call from several threads at once. */
+  void record(const std::vector<Move>& path, const PerftResult& result);
+
+  /* Number of finished units. */
+  auto size() const -> size_t;
+
+private:
+  PerftCheckpoint() = default;
+
+  static auto key(const std::vector<Move>& path) -> std::string;
+
+  std::map<std::string, PerftResult> m_units;
+  std::ofstream m_file;
+  mutable std::mutex m_mutex;
+};
+
+} // namespace yak
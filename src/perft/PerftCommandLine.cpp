@@ -0,0 +1,32 @@
+#include "PerftCommandLine.h"
+
+#include <charconv>
+#include <iostream>
+#include <string_view>
+#include <system_error>
+
+namespace yak {
+
+auto parsePositive(const char* name, const char* value, int minimum) -> std::optional<int>
+{
+  // The whole value has to be a number, so that "8abc" isn't taken to be 8
+  const std::string_view text{ value };
+
+  int parsed{ 0 };
+  const auto [end, error] = std::from_chars(text.data(), text.data() + text.size(), parsed);
+  if (error != std::errc{} || end != text.data() + text.size())
+  {
+    std::cerr << "Could not parse " << name << " argument: " << value << "\n";
+    return std::nullopt;
+  }
+
+  if (parsed < minimum)
+  {
+    std::cerr << "Minimum value for " << name << " is " << minimum << "\n";
+    return std::nullopt;
+  }
+
+  return parsed;
+}
+
+} // namespace yak
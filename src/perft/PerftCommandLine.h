@@ -0,0 +1,13 @@
+#pragma once
+
+#include <optional>
+
+namespace yak {
+
+/*
+ * Parses the value of a numeric command line option, which must be at least minimum. A value that
+ * isn't a number or is too small is reported on stderr, under the name of the option.
+ */
+auto parsePositive(const char* name, const char* value, int minimum) -> std::optional<int>;
+
+} // namespace yak
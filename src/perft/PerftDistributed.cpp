@@ -0,0 +1,540 @@
+#include "PerftDistributed.h"
+
+#include <board.h>
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <cstring>
+#include <deque>
+#include <map>
+#include <optional>
+#include <ostream>
+#include <sstream>
+#include <string_view>
+#include <system_error>
+#include <thread>
+
+#include <netdb.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+namespace yak {
+
+namespace {
+
+struct Address
+{
+  bool m_unix{ false };
+  std::string m_path;
+  std::string m_host;
+  std::string m_port;
+};
+
+auto parseAddress(const std::string& address) -> Address
+{
+  Address parsed{};
+
+  if (address.rfind("unix:", 0) == 0)
+  {
+    parsed.m_unix = true;
+    parsed.m_path = address.substr(5);
+    return parsed;
+  }
+
+  const auto separator = address.rfind(':');
+  if (separator == std::string::npos)
+  {
+    parsed.m_port = address;
+  }
+  else
+  {
+    parsed.m_host = address.substr(0, separator);
+    parsed.m_port = address.substr(separator + 1);
+  }
+
+  return parsed;
+}
+
+auto unixAddress(const Address& address, sockaddr_un& socketAddress) -> bool
+{
+  std::memset(&socketAddress, 0, sizeof(socketAddress));
+  socketAddress.sun_family = AF_UNIX;
+
+  if (address.m_path.empty() || address.m_path.size() >= sizeof(socketAddress.sun_path)) return false;
+
+  std::memcpy(socketAddress.sun_path, address.m_path.c_str(), address.m_path.size());
+  return true;
+}
+
+/*
+ * Call fn with each of the TCP addresses of a host and port, until it returns a socket.
+ */
+template<typename Fn>
+auto forEachTcpAddress(const Address& address, bool passive, Fn fn) -> int
+{
+  addrinfo hints{};
+  hints.ai_family = AF_UNSPEC;
+  hints.ai_socktype = SOCK_STREAM;
+  hints.ai_flags = passive ? AI_PASSIVE : 0;
+
+  addrinfo* addresses{ nullptr };
+  const char* host = address.m_host.empty() ? nullptr : address.m_host.c_str();
+  if (::getaddrinfo(host, address.m_port.c_str(), &hints, &addresses) != 0) return -1;
+
+  int fd{ -1 };
+  for (addrinfo* info = addresses; info != nullptr && fd < 0; info = info->ai_next)
+  {
+    fd = fn(info);
+  }
+
+  ::freeaddrinfo(addresses);
+  return fd;
+}
+
+auto listenOn(const Address& address) -> int
+{
+  int fd{ -1 };
+
+  if (address.m_unix)
+  {
+    sockaddr_un socketAddress{};
+    if (not unixAddress(address, socketAddress)) throw std::system_error(EINVAL, std::generic_category(), "socket path");
+
+    // A socket file left by an earlier coordinator would stop the bind
+    ::unlink(address.m_path.c_str());
+
+    fd = ::socket(AF_UNIX, SOCK_STREAM, 0);
+    if (fd >= 0 && ::bind(fd, reinterpret_cast<sockaddr*>(&socketAddress), sizeof(socketAddress)) != 0)
+    {
+      ::close(fd);
+      fd = -1;
+    }
+  }
+  else
+  {
+    fd = forEachTcpAddress(address, true, [](addrinfo* info)
+    {
+      int fd = ::socket(info->ai_family, info->ai_socktype, info->ai_protocol);
+      if (fd < 0) return -1;
+
+      int reuse{ 1 };
+      ::setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &reuse, sizeof(reuse));
+
+      if (::bind(fd, info->ai_addr, info->ai_addrlen) != 0)
+      {
+        ::close(fd);
+        return -1;
+      }
+
+      return fd;
+    });
+  }
+
+  if (fd < 0 || ::listen(fd, SOMAXCONN) != 0)
+  {
+    const int error = errno;
+    if (fd >= 0) ::close(fd);
+    throw std::system_error(error, std::generic_category(), "could not listen for perft workers");
+  }
+
+  return fd;
+}
+
+auto connectTo(const Address& address) -> int
+{
+  if (address.m_unix)
+  {
+    sockaddr_un socketAddress{};
+    if (not unixAddress(address, socketAddress)) return -1;
+
+    int fd = ::socket(AF_UNIX, SOCK_STREAM, 0);
+    if (fd >= 0 && ::connect(fd, reinterpret_cast<sockaddr*>(&socketAddress), sizeof(socketAddress)) != 0)
+    {
+      ::close(fd);
+      return -1;
+    }
+
+    return fd;
+  }
+
+  return forEachTcpAddress(address, false, [](addrinfo* info)
+  {
+    int fd = ::socket(info->ai_family, info->ai_socktype, info->ai_protocol);
+    if (fd >= 0 && ::connect(fd, info->ai_addr, info->ai_addrlen) != 0)
+    {
+      ::close(fd);
+      return -1;
+    }
+
+    return fd;
+  });
+}
+
+auto sendLine(int fd, const std::string& line) -> bool
+{
+  size_t sent{ 0 };
+  while (sent < line.size())
+  {
+    // MSG_NOSIGNAL, so that a peer that has gone away is an error rather than a SIGPIPE
+    const auto result = ::send(fd, line.data() + sent, line.size() - sent, MSG_NOSIGNAL);
+    if (result < 0 && errno == EINTR) continue;
+    if (result <= 0) return false;
+
+    sent += static_cast<size_t>(result);
+  }
+
+  return true;
+}
+
+/*
+ * Splits the bytes read from a socket into lines.
+ */
+class LineReader
+{
+public:
+  /* Read what is available, returning false once the socket is closed or fails. */
+  auto read(int fd) -> bool
+  {
+    char buffer[4096];
+
+    ssize_t result{ 0 };
+    do
+    {
+      result = ::recv(fd, buffer, sizeof(buffer), 0);
+    } while (result < 0 && errno == EINTR);
+
+    if (result <= 0) return false;
+
+    m_buffer.append(buffer, static_cast<size_t>(result));
+    return true;
+  }
+
+  auto next() -> std::optional<std::string>
+  {
+    const auto end = m_buffer.find('\n');
+    if (end == std::string::npos) return std::nullopt;
+
+    std::string line = m_buffer.substr(0, end);
+    m_buffer.erase(0, end + 1);
+    return line;
+  }
+
+private:
+  std::string m_buffer;
+};
+
+struct Unit
+{
+  std::string m_fen;
+
+  /* The root move of each path that reaches the unit's position. */
+  std::vector<size_t> m_roots;
+
+  /* Number of workers counting the unit. */
+  int m_holders{ 0 };
+  bool m_done{ false };
+};
+
+struct Client
+{
+  int m_fd{ -1 };
+  size_t m_id{ 0 };
+  LineReader m_reader;
+  std::optional<size_t> m_unit;
+};
+
+void splitTree(Board& board, int depth, size_t root, std::map<std::string, size_t>& positions, std::vector<Unit>& units)
+{
+  if (depth == 0)
+  {
+    const auto fen = board.toFen();
+
+    auto [position, added] = positions.try_emplace(fen, units.size());
+    if (added) units.push_back(Unit{ fen, {}, 0, false });
+
+    units[position->second].m_roots.push_back(root);
+    return;
+  }
+
+  for (const auto& move : board.generateMoves())
+  {
+    board.makeMove(move);
+    splitTree(board, depth - 1, root, positions, units);
+    (void) board.undoMove();
+  }
+}
+
+auto formatResult(size_t id, const PerftResult& result) -> std::string
+{
+  std::ostringstream line;
+  line << "result " << id << " " << result.m_total << " " << result.m_captures << " " << result.m_ep << " "
+       << result.m_castles << " " << result.m_promotions << " " << result.m_checks << " " << result.m_checkmates << "\n";
+  return line.str();
+}
+
+} // namespace
+
+auto perftCoordinator(Board& board, int depth, const DistributedOptions& options)
+  -> std::vector<std::pair<Move, PerftResult>>
+{
+  if (depth < 2) return perftDivide(board, depth);
+
+  const auto rootMoves = board.generateMoves();
+  const int remainingDepth = depth - std::clamp(options.m_splitDepth, 1, depth - 1);
+
+  std::vector<std::pair<Move, PerftResult>> divide;
+  std::vector<Unit> units;
+  std::map<std::string, size_t> positions;
+
+  for (size_t root = 0; root < rootMoves.size(); ++root)
+  {
+    divide.emplace_back(rootMoves[root], PerftResult{});
+
+    board.makeMove(rootMoves[root]);
+    splitTree(board, depth - remainingDepth - 1, root, positions, units);
+    (void) board.undoMove();
+  }
+
+  std::deque<size_t> pending;
+  for (size_t unit = 0; unit < units.size(); ++unit)
+  {
+    pending.push_back(unit);
+  }
+
+  const Address address = parseAddress(options.m_address);
+  const int listener = listenOn(address);
+
+  auto log = [&options](const std::string& message)
+  {
+    if (options.m_log) *options.m_log << message << std::endl;
+  };
+
+  std::vector<Client> clients;
+  size_t nextClientId{ 0 };
+  size_t done{ 0 };
+
+  // Hand out the next unit, or once they have all gone, a copy of the unit being counted by the
+  // fewest workers.
+  auto assign = [&](Client& client) -> bool
+  {
+    std::optional<size_t> unit;
+    if (not pending.empty())
+    {
+      unit = pending.front();
+      pending.pop_front();
+    }
+    else
+    {
+      for (size_t candidate = 0; candidate < units.size(); ++candidate)
+      {
+        if (units[candidate].m_done) continue;
+        if (not unit || units[candidate].m_holders < units[*unit].m_holders) unit = candidate;
+      }
+    }
+
+    if (not unit) return true;
+
+    client.m_unit = unit;
+    ++units[*unit].m_holders;
+
+    return sendLine(client.m_fd, "unit " + std::to_string(*unit) + " " + std::to_string(remainingDepth) + " "
+                    + units[*unit].m_fen + "\n");
+  };
+
+  auto release = [&](Client& client)
+  {
+    if (not client.m_unit) return;
+
+    auto& unit = units[*client.m_unit];
+    --unit.m_holders;
+    if (not unit.m_done && unit.m_holders == 0) pending.push_front(*client.m_unit);
+
+    client.m_unit.reset();
+  };
+
+  auto handleLine = [&](Client& client, const std::string& line) -> bool
+  {
+    std::istringstream fields{ line };
+
+    std::string command;
+    size_t id{ 0 };
+    PerftResult result{};
+    fields >> command >> id >> result.m_total >> result.m_captures >> result.m_ep >> result.m_castles
+      >> result.m_promotions >> result.m_checks >> result.m_checkmates;
+
+    if (not fields || command != "result" || not client.m_unit || *client.m_unit != id) return false;
+
+    // A unit counted twice, because a copy was handed out, is only added once
+    if (not units[id].m_done)
+    {
+      units[id].m_done = true;
+      ++done;
+
+      for (const auto root : units[id].m_roots)
+      {
+        divide[root].second += result;
+      }
+    }
+
+    release(client);
+    return assign(client);
+  };
+
+  log("Waiting for workers on " + options.m_address + " to count " + std::to_string(units.size()) + " units");
+
+  while (done < units.size())
+  {
+    std::vector<pollfd> fds;
+    fds.push_back(pollfd{ listener, POLLIN, 0 });
+    for (const auto& client : clients)
+    {
+      fds.push_back(pollfd{ client.m_fd, POLLIN, 0 });
+    }
+
+    if (::poll(fds.data(), fds.size(), -1) < 0)
+    {
+      if (errno == EINTR) continue;
+
+      // The count is incomplete, so it is an error rather than a result
+      const int error = errno;
+      for (const auto& client : clients)
+      {
+        ::close(client.m_fd);
+      }
+      ::close(listener);
+      if (address.m_unix) ::unlink(address.m_path.c_str());
+
+      throw std::system_error(error, std::generic_category(), "poll");
+    }
+
+    // Clients are only added and removed after the events of this poll have been handled, so that
+    // the indices of fds and clients line up.
+    std::vector<size_t> lost;
+    for (size_t i = 0; i < clients.size(); ++i)
+    {
+      if (fds[i + 1].revents == 0) continue;
+
+      auto& client = clients[i];
+      bool ok = client.m_reader.read(client.m_fd);
+      while (ok && done < units.size())
+      {
+        auto line = client.m_reader.next();
+        if (not line) break;
+        ok = handleLine(client, *line);
+      }
+
+      if (not ok) lost.push_back(i);
+    }
+
+    for (auto i = lost.rbegin(); i != lost.rend(); ++i)
+    {
+      auto& client = clients[*i];
+      if (client.m_unit) log("Worker " + std::to_string(client.m_id) + " lost, handing out unit " + std::to_string(*client.m_unit) + " again");
+      else log("Worker " + std::to_string(client.m_id) + " left");
+
+      release(client);
+      ::close(client.m_fd);
+      clients.erase(clients.begin() + static_cast<std::ptrdiff_t>(*i));
+    }
+
+    if (fds[0].revents & POLLIN)
+    {
+      const int fd = ::accept(listener, nullptr, nullptr);
+      if (fd >= 0)
+      {
+        clients.push_back(Client{ fd, nextClientId++, {}, {} });
+        log("Worker " + std::to_string(clients.back().m_id) + " joined");
+
+        if (not assign(clients.back()))
+        {
+          release(clients.back());
+          ::close(fd);
+          clients.pop_back();
+        }
+      }
+    }
+  }
+
+  for (auto& client : clients)
+  {
+    (void) sendLine(client.m_fd, "quit\n");
+    ::close(client.m_fd);
+  }
+
+  ::close(listener);
+  if (address.m_unix) ::unlink(address.m_path.c_str());
+
+  return divide;
+}
+
+bool perftWorker(const std::string& address, const PerftOptions& options, double connectSeconds)
+{
+  const Address parsed = parseAddress(address);
+  const auto deadline = std::chrono::steady_clock::now() + std::chrono::duration<double>(connectSeconds);
+
+  int fd = connectTo(parsed);
+  while (fd < 0 && std::chrono::steady_clock::now() < deadline)
+  {
+    std::this_thread::sleep_for(std::chrono::milliseconds(100));
+    fd = connectTo(parsed);
+  }
+
+  if (fd < 0) return false;
+
+  Board board;
+  LineReader reader;
+
+  while (true)
+  {
+    auto line = reader.next();
+    if (not line)
+    {
+      if (reader.read(fd)) continue;
+
+      ::close(fd);
+      return false;
+    }
+
+    if (*line == "quit") break;
+
+    std::istringstream fields{ *line };
+
+    std::string command;
+    size_t id{ 0 };
+    int depth{ 0 };
+    fields >> command >> id >> depth;
+
+    std::string fen;
+    std::getline(fields >> std::ws, fen);
+
+    if (command != "unit" || not board.reset(fen))
+    {
+      ::close(fd);
+      return false;
+    }
+
+    if (not sendLine(fd, formatResult(id, perft(board, depth, options))))
+    {
+      // The coordinator may have finished while this unit was being counted, as it was a copy, in
+      // which case it has already said to quit.
+      bool quit{ false };
+      do
+      {
+        while (auto pending = reader.next())
+        {
+          quit = quit || (*pending == "quit");
+        }
+      } while (not quit && reader.read(fd));
+
+      ::close(fd);
+      return quit;
+    }
+  }
+
+  ::close(fd);
+  return true;
+}
+
+} // namespace yak
@@ -0,0 +1,67 @@
+#pragma once
+
+#include "Perft.h"
+
+#include <cstddef>
+#include <iosfwd>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include <types.h>
+
+namespace yak {
+
+class Board;
+
+/*
+ * Perft shared between processes, possibly on other hosts.
+ *
+ * A coordinator splits the tree a number of plies below the root into work units, each a position
+ * and the depth left to count, and hands them out to the workers that connect to it, one at a
+ * time. Positions reached by more than one path are only counted once. A worker counts each unit
+ * it is given with all of its own threads, and sends back the result.
+ *
+ * Units held by a worker that disconnects are handed out again. Once every unit has been handed
+ * out, idle workers are given copies of the units still being counted, and whichever copy finishes
+ * first is used, so that a stalled or slow worker doesn't hold up the end of the run.
+ *
+ * Addresses are either "unix:<path>" for a Unix domain socket, or "<host>:<port>" for TCP, where
+ * a coordinator may leave out the host to listen on every interface.
+ *
+ * The protocol is lines of text, from the coordinator
+ *
+ *   unit <id> <depth> <fen>
+ *   quit
+ *
+ * and from a worker
+ *
+ *   result <id> <total> <captures> <ep> <castles> <promotions> <checks> <checkmates>
+ */
+struct DistributedOptions
+{
+  std::string m_address;
+
+  /* Plies expanded by the coordinator to make the work units. */
+  int m_splitDepth{ 3 };
+
+  /* Where to report workers joining and leaving, or null for no reports. */
+  std::ostream* m_log{ nullptr };
+};
+
+/*
+ * Run a coordinator for a perft of the board, returning the counts of each root move in generation
+ * order once every unit has been counted, as perftDivide. Throws std::system_error if the address
+ * can't be listened on.
+ */
+auto perftCoordinator(Board& board, int depth, const DistributedOptions& options)
+  -> std::vector<std::pair<Move, PerftResult>>;
+
+/*
+ * Run a worker, counting the units given to it by the coordinator at address with the given perft
+ * options until it is told to quit. Connecting is retried for up to connectSeconds, in case the
+ * coordinator is still starting. Returns false if it never connects, or the connection is lost.
+ */
+bool perftWorker(const std::string& address, const PerftOptions& options, double connectSeconds = 10.0);
+
+} // namespace yak
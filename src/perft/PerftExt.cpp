@@ -1,41 +1,246 @@
 #include "Perft.h"
+#include "PerftCheckpoint.h"
+#include "PerftCommandLine.h"
+#include "PerftDistributed.h"
 
 #include <board.h>
 #include <cctype>
+#include <chrono>
+#include <condition_variable>
+#include <iomanip>
 #include <iostream>
+#include <memory>
+#include <mutex>
+#include <sstream>
+#include <string>
+#include <string_view>
+#include <system_error>
+#include <thread>
+#include <utility>
+#include <vector>
+
+namespace {
+
+void printUsage()
+{
+  std::cout << "\nPerftExt: A command line perft function\n\n";
+  std::cout << "Usage:\n";
+  std::cout << "PerftExt <depth> <fen> [options]\n";
+  std::cout << "PerftExt --worker <address> [options]\n\n";
+  std::cout << "Options:\n";
+  std::cout << "  --threads <n>          Number of threads to use (default: one per hardware thread)\n";
+  std::cout << "  --split-depth <n>      Plies to expand before handing out work to the threads (default: 2)\n";
+  std::cout << "  --hash <MB>            Cache node counts in a transposition table of the given size\n";
+  std::cout << "  --checkpoint <file>    Record finished work in the file, and skip work recorded by an earlier run\n";
+  std::cout << "  --coordinator <addr>   Hand the work out to workers connecting to the address, unix:<path> or [host]:<port>\n";
+  std::cout << "  --progress <seconds>   Print progress to stderr as a JSON line every so many seconds\n";
+  std::cout << "  --checksum             Print the sum of the leaf hashes and the legal move counts at each ply rather than\n";
+  std::cout << "                         the divide, to compare with another move generator (single threaded, and slower)\n";
+}
+
+/*
+ * A JSON line of progress. The rate is over the time since the last line, and the time remaining
+ * is that of the estimated nodes left (see PerftProgress::Snapshot) at the average rate so far.
+ */
+void printProgress(const yak::PerftProgress::Snapshot& snapshot, const yak::PerftProgress::Snapshot& last, bool done)
+{
+  const double interval = snapshot.m_seconds - last.m_seconds;
+  const double nps = (interval > 0.0) ? static_cast<double>(snapshot.m_nodes - last.m_nodes) / interval : 0.0;
+  const double averageNps = (snapshot.m_seconds > 0.0) ? static_cast<double>(snapshot.m_nodes) / snapshot.m_seconds : 0.0;
+
+  std::ostringstream line;
+  line << std::fixed << std::setprecision(3);
+  line << "{\"elapsed\":" << snapshot.m_seconds
+       << ",\"nodes\":" << snapshot.m_nodes
+       << ",\"nps\":" << static_cast<uint64_t>(nps)
+       << ",\"average_nps\":" << static_cast<uint64_t>(averageNps)
+       << ",\"units_done\":" << snapshot.m_unitsDone
+       << ",\"units\":" << snapshot.m_units
+       << ",\"estimated_nodes\":" << snapshot.m_estimatedNodes
+       << ",\"eta\":";
+
+  if (snapshot.m_estimatedNodes && averageNps > 0.0)
+  {
+    line << static_cast<double>(snapshot.m_estimatedNodes - snapshot.m_nodes) / averageNps;
+  }
+  else
+  {
+    line << "null";
+  }
+
+  line << ",\"utilisation\":[";
+  for (size_t worker = 0; worker < snapshot.m_utilisation.size(); ++worker)
+  {
+    line << (worker ? "," : "") << snapshot.m_utilisation[worker];
+  }
+
+  line << "],\"done\":" << (done ? "true" : "false") << "}\n";
+  std::cerr << line.str() << std::flush;
+}
+
+/*
+ * The checksum, and for each ply a line of "<legal moves>:<positions>" for every number of legal
+ * moves seen at that ply.
+ */
+void printChecksum(const yak::PerftChecksum& checksum)
+{
+  std::cout << " Leaf positions: " << checksum.m_nodes << "\n";
+  std::cout << " Leaf hash sum: 0x" << std::hex << std::setw(16) << std::setfill('0') << checksum.m_leafHashSum
+            << std::dec << std::setfill(' ') << "\n\n";
+
+  for (size_t ply = 0; ply < checksum.m_moveCounts.size(); ++ply)
+  {
+    std::cout << " Ply " << ply << ":";
+
+    const auto& moveCounts = checksum.m_moveCounts[ply];
+    for (size_t moves = 0; moves < moveCounts.size(); ++moves)
+    {
+      if (moveCounts[moves]) std::cout << " " << moves << ":" << moveCounts[moves];
+    }
+
+    std::cout << "\n";
+  }
+
+  std::cout << "\n";
+}
+
+struct CommandLine
+{
+  yak::PerftOptions m_options;
+  std::string m_checkpointPath;
+  std::string m_coordinatorAddress;
+  int m_progressSeconds{ 0 };
+  bool m_checksum{ false };
+};
+
+auto parseOptions(int argv, char** argc, int first, CommandLine& commandLine) -> bool
+{
+  auto& options = commandLine.m_options;
+
+  for (int i = first; i < argv; ++i)
+  {
+    const std::string_view option{ argc[i] };
+
+    if (option == "--checksum")
+    {
+      commandLine.m_checksum = true;
+      continue;
+    }
+
+    if (i + 1 >= argv)
+    {
+      std::cerr << "Missing value for option: " << option << "\n";
+      return false;
+    }
+
+    if (option == "--threads")
+    {
+      auto threads = yak::parsePositive("threads", argc[++i], 1);
+      if (not threads) return false;
+      options.m_threads = *threads;
+    }
+    else if (option == "--split-depth")
+    {
+      auto splitDepth = yak::parsePositive("split depth", argc[++i], 1);
+      if (not splitDepth) return false;
+      options.m_splitDepth = *splitDepth;
+    }
+    else if (option == "--hash")
+    {
+      auto megabytes = yak::parsePositive("hash", argc[++i], 1);
+      if (not megabytes) return false;
+      options.m_hashMegabytes = *megabytes;
+    }
+    else if (option == "--checkpoint")
+    {
+      commandLine.m_checkpointPath = argc[++i];
+    }
+    else if (option == "--progress")
+    {
+      auto seconds = yak::parsePositive("progress", argc[++i], 1);
+      if (not seconds) return false;
+      commandLine.m_progressSeconds = *seconds;
+    }
+    else if (option == "--coordinator")
+    {
+      commandLine.m_coordinatorAddress = argc[++i];
+    }
+    else
+    {
+      std::cerr << "Unknown option: " << option << "\n";
+      printUsage();
+      return false;
+    }
+  }
+
+  return true;
+}
+
+} // namespace
 
 int main(int argv, char** argc)
 {
   // Check that we have received the correct number of arguments
   if (argv < 3)
   {
-    std::cout << "\nPerftExt: A command line perft function\n\n";
-    std::cout << "Usage:\n";
-    std::cout << "PerftExt <depth> <fen>\n";
-
+    printUsage();
     return 0;
   }
 
+  CommandLine commandLine{};
+  auto& options = commandLine.m_options;
+
+  // Workers are given their positions by the coordinator
+  if (std::string_view{ argc[1] } == "--worker")
+  {
+    if (not parseOptions(argv, argc, 3, commandLine)) return 1;
+
+    if (commandLine.m_checksum || commandLine.m_progressSeconds || not commandLine.m_checkpointPath.empty()
+        || not commandLine.m_coordinatorAddress.empty())
+    {
+      std::cerr << "--worker can't be combined with --checksum, --progress, --checkpoint or --coordinator\n";
+      return 1;
+    }
+
+    yak::ThreadPool::shared(options.m_threads);
+    return yak::perftWorker(argc[2], options) ? 0 : 1;
+  }
+
   // Set the depth and check that it is valid
-  int depth;
-  try
+  auto depth = yak::parsePositive("depth", argc[1], 1);
+  if (not depth) return 1;
+
+  if (not parseOptions(argv, argc, 3, commandLine)) return 1;
+
+  if (commandLine.m_progressSeconds && not commandLine.m_coordinatorAddress.empty())
   {
-    depth = std::stoi(argc[1]);
+    std::cerr << "Progress is only reported when counting locally, not with --coordinator\n";
+    return 1;
   }
-  catch (std::exception& e)
+
+  if (not commandLine.m_checkpointPath.empty() && not commandLine.m_coordinatorAddress.empty())
   {
-    std::cerr << "Could not parse depth argument: " << argc[1] << " (" << e.what() << ")\n";
+    std::cerr << "Checkpoints are only kept when counting locally, not with --coordinator\n";
     return 1;
   }
 
-  if (depth < 1)
+  if ((options.m_threads || options.m_hashMegabytes) && not commandLine.m_coordinatorAddress.empty())
   {
-    std::cerr << "Minimum value for depth is 1" << "\n";
+    std::cerr << "The coordinator doesn't count, so --threads and --hash are given to its workers instead\n";
     return 1;
   }
 
+  if (commandLine.m_checksum
+      && (commandLine.m_progressSeconds || not commandLine.m_coordinatorAddress.empty() || not commandLine.m_checkpointPath.empty()))
+  {
+    std::cerr << "--checksum can't be combined with --progress, --coordinator or --checkpoint\n";
+    return 1;
+  }
+
+  // Size the shared pool before it is first used
+  yak::ThreadPool::shared(options.m_threads);
+
   // Initialise the board and check the provided FEN string was valid
-  std::string fen{ argc[2] };
   yak::Board board;
   if (not board.reset( argc[2] ))
   {
@@ -45,28 +250,105 @@ int main(int argv, char** argc)
 
   std::cout << "Provided FEN: " << board.toFen() << "\n\n";
 
-  auto moves = board.generateMoves();
-  --depth;
+  if (commandLine.m_checksum)
+  {
+    printChecksum(yak::perftChecksum(board, *depth));
+    return 0;
+  }
 
-  int total{ 0 };
-  for (const auto& move : moves)
+  std::unique_ptr<yak::PerftCheckpoint> checkpoint;
+  if (not commandLine.m_checkpointPath.empty())
   {
-    if (depth > 0)
+    std::string error;
+    const bool totalsOnly = (options.m_hashMegabytes > 0);
+    checkpoint = yak::PerftCheckpoint::open(commandLine.m_checkpointPath, board.toFen(), *depth, totalsOnly, error);
+    if (not checkpoint)
+    {
+      std::cerr << "Could not use checkpoint: " << error << "\n";
+      return 1;
+    }
+
+    if (checkpoint->size() > 0)
+    {
+      std::cout << "Resuming with " << checkpoint->size() << " finished work units from " << commandLine.m_checkpointPath << "\n\n";
+    }
+    options.m_checkpoint = checkpoint.get();
+  }
+
+  std::vector<std::pair<yak::Move, yak::PerftResult>> divide;
+  if (not commandLine.m_coordinatorAddress.empty())
+  {
+    yak::DistributedOptions distributed{};
+    distributed.m_address = commandLine.m_coordinatorAddress;
+    distributed.m_splitDepth = options.m_splitDepth;
+    distributed.m_log = &std::cerr;
+
+    try
+    {
+      divide = yak::perftCoordinator(board, *depth, distributed);
+    }
+    catch (const std::system_error& e)
+    {
+      std::cerr << "The coordinator failed: " << e.what() << "\n";
+      return 1;
+    }
+  }
+  else if (commandLine.m_progressSeconds)
+  {
+    auto& threadPool = yak::ThreadPool::shared();
+    yak::PerftProgress progress{ options.m_threads ? options.m_threads : threadPool.size() };
+    options.m_progress = &progress;
+
+    std::mutex mutex;
+    std::condition_variable finished;
+    bool done{ false };
+
+    std::thread reporter([&]
+    {
+      yak::PerftProgress::Snapshot last{};
+
+      std::unique_lock<std::mutex> lock(mutex);
+      while (not finished.wait_for(lock, std::chrono::seconds(commandLine.m_progressSeconds), [&done] { return done; }))
+      {
+        auto snapshot = progress.snapshot();
+        printProgress(snapshot, last, false);
+        last = std::move(snapshot);
+      }
+
+      printProgress(progress.snapshot(), last, true);
+    });
+
+    divide = yak::perftDivide(board, *depth, options);
+
+    {
+      std::unique_lock<std::mutex> lock(mutex);
+      done = true;
+    }
+
+    finished.notify_one();
+    reporter.join();
+  }
+  else
+  {
+    divide = yak::perftDivide(board, *depth, options);
+  }
+
+  size_t total{ 0 };
+  for (const auto& [move, result] : divide)
+  {
+    if (*depth > 1)
     {
-      board.makeMove(move);
-      auto result = perft(board, depth);
       std::cout << " " << yak::toAlgebraic(move) << " " << result.m_total << "\n";
-      total += result.m_total;
-      board.undoMove();
-      continue;
+    }
+    else
+    {
+      std::cout << yak::toAlgebraic(move) << " " << result.m_total << "\n";
     }
 
-    std::cout << yak::toAlgebraic(move) << " " << 1 << "\n";
-    ++total;
+    total += result.m_total;
   }
 
   std::cout << "\n Total moves: " << total << "\n\n";
 
   return 0;
 }
-
@@ -0,0 +1,88 @@
+#pragma once
+
+#include <LargeBuffer.h>
+#include <zobrist.h>
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <new>
+#include <optional>
+
+namespace yak {
+
+/*
+ * A fixed size cache of perft node counts, keyed on the position hash and the remaining depth, that
+ * is shared by every perft worker without any locking.
+ *
+ * Each entry is two words, the data (node count and depth) and the hash XOR the data. The words are
+ * written separately, so a reader can see half of one write and half of another, but then the XOR
+ * of the two no longer gives the hash being looked up, and the entry is treated as a miss (the
+ * "lockless hashing" scheme). Entries are always replaced.
+ */
+class PerftHashTable
+{
+public:
+  explicit PerftHashTable(size_t megabytes)
+  {
+    // Round down to a power of two number of entries, so the index is a mask of the hash.
+    size_t entries{ 1 };
+    while (entries * 2 * sizeof(Entry) <= megabytes * 1024 * 1024)
+    {
+      entries *= 2;
+    }
+
+    m_buffer = memory::LargeBuffer{ entries * sizeof(Entry) };
+    m_entries = m_buffer.as<Entry>();
+    m_mask = entries - 1;
+
+    for (size_t i = 0; i < entries; ++i)
+    {
+      new (&m_entries[i]) Entry{};
+    }
+  }
+
+  auto probe(zobrist::Key hash, int depth) const -> std::optional<uint64_t>
+  {
+    const Entry& entry = m_entries[hash & m_mask];
+
+    const uint64_t data = entry.m_data.load(std::memory_order_relaxed);
+    const uint64_t check = entry.m_check.load(std::memory_order_relaxed);
+
+    if ((check ^ data) != hash || (data & DEPTH_MASK) != static_cast<uint64_t>(depth))
+    {
+      return std::nullopt;
+    }
+
+    return data >> DEPTH_BITS;
+  }
+
+  void store(zobrist::Key hash, int depth, uint64_t nodes)
+  {
+    Entry& entry = m_entries[hash & m_mask];
+
+    const uint64_t data = (nodes << DEPTH_BITS) | static_cast<uint64_t>(depth);
+
+    entry.m_data.store(data, std::memory_order_relaxed);
+    entry.m_check.store(hash ^ data, std::memory_order_relaxed);
+  }
+
+  auto size() const -> size_t { return m_mask + 1; }
+  auto pageMode() const -> memory::PageMode { return m_buffer.pageMode(); }
+
+private:
+  static constexpr int DEPTH_BITS{ 8 };
+  static constexpr uint64_t DEPTH_MASK{ (1 << DEPTH_BITS) - 1 };
+
+  struct Entry
+  {
+    std::atomic<uint64_t> m_check{ 0 };
+    std::atomic<uint64_t> m_data{ 0 };
+  };
+
+  memory::LargeBuffer m_buffer;
+  Entry* m_entries{ nullptr };
+  size_t m_mask{ 0 };
+};
+
+} // namespace yak
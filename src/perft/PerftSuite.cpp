@@ -0,0 +1,229 @@
+#include "PerftSuite.h"
+#include "Perft.h"
+
+#include <board.h>
+#include <algorithm>
+#include <cctype>
+#include <charconv>
+#include <chrono>
+#include <future>
+#include <istream>
+#include <mutex>
+
+namespace yak {
+
+namespace {
+
+auto trim(std::string_view text) -> std::string_view
+{
+  while (not text.empty() && std::isspace(static_cast<unsigned char>(text.front()))) text.remove_prefix(1);
+  while (not text.empty() && std::isspace(static_cast<unsigned char>(text.back()))) text.remove_suffix(1);
+  return text;
+}
+
+auto countFields(std::string_view text) -> int
+{
+  int fields{ 0 };
+  bool inField{ false };
+  for (char c : text)
+  {
+    const bool space = std::isspace(static_cast<unsigned char>(c));
+    if (not space && not inField) ++fields;
+    inField = not space;
+  }
+  return fields;
+}
+
+template<typename T>
+auto parseNumber(std::string_view text) -> std::optional<T>
+{
+  T value{};
+  const auto [end, error] = std::from_chars(text.data(), text.data() + text.size(), value);
+  if (error != std::errc{} || end != text.data() + text.size()) return std::nullopt;
+  return value;
+}
+
+/*
+ * The next position of the suite, skipping blank lines and comments, or nullopt at the end.
+ */
+struct SuiteReader
+{
+  std::istream& m_input;
+  std::mutex m_mutex;
+  size_t m_line{ 0 };
+
+  auto next() -> std::optional<std::pair<size_t, std::string>>
+  {
+    std::unique_lock<std::mutex> lock(m_mutex);
+
+    std::string line;
+    while (std::getline(m_input, line))
+    {
+      ++m_line;
+
+      const auto text = trim(line);
+      if (text.empty() || text.front() == '#') continue;
+
+      return std::make_pair(m_line, std::string{ text });
+    }
+
+    return std::nullopt;
+  }
+};
+
+} // namespace
+
+auto parseEpdLine(std::string_view line) -> std::optional<EpdPosition>
+{
+  EpdPosition position{};
+
+  const auto endOfFen = line.find(';');
+  const auto fen = trim(line.substr(0, endOfFen));
+
+  const int fields = countFields(fen);
+  if (fields == 4)
+  {
+    position.m_fen = std::string{ fen } + " 0 1";
+  }
+  else if (fields == 6)
+  {
+    position.m_fen = fen;
+  }
+  else
+  {
+    return std::nullopt;
+  }
+
+  // Each count is an operation such as ";D3 8902", anything else on the line is ignored
+  auto rest = (endOfFen == std::string_view::npos) ? std::string_view{} : line.substr(endOfFen + 1);
+  while (not rest.empty())
+  {
+    const auto endOfOperation = rest.find(';');
+    const auto operation = trim(rest.substr(0, endOfOperation));
+    rest = (endOfOperation == std::string_view::npos) ? std::string_view{} : rest.substr(endOfOperation + 1);
+
+    if (operation.size() < 2 || operation.front() != 'D' || not std::isdigit(static_cast<unsigned char>(operation[1]))) continue;
+
+    const auto separator = operation.find_first_of(" \t");
+    if (separator == std::string_view::npos) return std::nullopt;
+
+    const auto depth = parseNumber<int>(operation.substr(1, separator - 1));
+    const auto nodes = parseNumber<uint64_t>(trim(operation.substr(separator)));
+    if (not depth || not nodes || *depth < 1) return std::nullopt;
+
+    position.m_expected.emplace_back(*depth, *nodes);
+  }
+
+  if (position.m_expected.empty()) return std::nullopt;
+
+  std::sort(position.m_expected.begin(), position.m_expected.end());
+  return position;
+}
+
+auto runEpdPosition(const EpdPosition& position, int maxDepth, bool checksum) -> EpdResult
+{
+  EpdResult result{};
+  result.m_position = position;
+
+  Board board;
+  if (not board.reset(position.m_fen))
+  {
+    result.m_error = "invalid FEN";
+    return result;
+  }
+
+  const auto start = std::chrono::steady_clock::now();
+
+  result.m_passed = true;
+  for (const auto& [depth, expected] : position.m_expected)
+  {
+    if (maxDepth && depth > maxDepth) break;
+
+    // Positions are already spread across the threads, so each one is counted on a single thread
+    uint64_t nodes{ 0 };
+    if (checksum)
+    {
+      const auto tree = perftChecksum(board, depth);
+      nodes = tree.m_nodes;
+      result.m_checksum = tree.m_leafHashSum;
+    }
+    else
+    {
+      nodes = perftTotal(board, depth);
+    }
+
+    result.m_depth = depth;
+    result.m_nodes += nodes;
+
+    if (nodes != expected)
+    {
+      result.m_passed = false;
+      result.m_error = "D" + std::to_string(depth) + " expected " + std::to_string(expected) + ", counted " + std::to_string(nodes);
+      break;
+    }
+  }
+
+  result.m_seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+  return result;
+}
+
+auto runEpdSuite(std::istream& input,
+                 const EpdSuiteOptions& options,
+                 const std::function<void(const EpdResult&)>& report) -> EpdSummary
+{
+  const auto start = std::chrono::steady_clock::now();
+
+  SuiteReader reader{ input };
+
+  EpdSummary summary{};
+  std::mutex reportMutex;
+
+  auto worker = [&]
+  {
+    while (auto line = reader.next())
+    {
+      EpdResult result{};
+
+      if (auto position = parseEpdLine(line->second))
+      {
+        position->m_line = line->first;
+        result = runEpdPosition(*position, options.m_maxDepth, options.m_checksum);
+      }
+      else
+      {
+        result.m_position.m_line = line->first;
+        result.m_position.m_fen = line->second;
+        result.m_error = "could not parse line";
+      }
+
+      std::unique_lock<std::mutex> lock(reportMutex);
+      ++summary.m_positions;
+      summary.m_failed += result.m_passed ? 0 : 1;
+      summary.m_nodes += result.m_nodes;
+      summary.m_checksum += result.m_checksum;
+      report(result);
+    }
+  };
+
+  auto& threadPool = ThreadPool::shared();
+  const size_t numWorkers = options.m_threads ? options.m_threads : threadPool.size();
+
+  // The first worker runs on the calling thread, which would otherwise be waiting.
+  std::vector<std::future<void>> futures;
+  for (size_t i = 1; i < numWorkers; ++i)
+  {
+    futures.push_back(threadPool.enqueue(worker));
+  }
+
+  worker();
+
+  for (auto& future : futures)
+  {
+    future.get();
+  }
+
+  summary.m_seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+  return summary;
+}
+
+} // namespace yak
@@ -0,0 +1,94 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <iosfwd>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+namespace yak {
+
+/*
+ * A position of an EPD perft suite, and the node counts expected at each depth. Each line of a
+ * suite holds a FEN followed by the counts, for example
+ *
+ *   rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1 ;D1 20 ;D2 400 ;D3 8902
+ */
+struct EpdPosition
+{
+  size_t m_line{ 0 };
+  std::string m_fen;
+  std::vector<std::pair<int, uint64_t>> m_expected;
+};
+
+struct EpdResult
+{
+  EpdPosition m_position;
+
+  /* The deepest perft run, the one that failed if the position did not pass. */
+  int m_depth{ 0 };
+
+  /* Nodes counted over every depth run. */
+  uint64_t m_nodes{ 0 };
+  double m_seconds{ 0.0 };
+
+  bool m_passed{ false };
+  std::string m_error;
+
+  /* The leaf hash sum of the deepest perft, when run with checksums. */
+  uint64_t m_checksum{ 0 };
+};
+
+struct EpdSummary
+{
+  size_t m_positions{ 0 };
+  size_t m_failed{ 0 };
+  uint64_t m_nodes{ 0 };
+  double m_seconds{ 0.0 };
+
+  /* Sum of the checksums of the positions, so it doesn't depend on the order they finish in. */
+  uint64_t m_checksum{ 0 };
+};
+
+struct EpdSuiteOptions
+{
+  /* Number of positions run at once, 0 to use every thread of the shared pool. */
+  size_t m_threads{ 0 };
+
+  /* Skip the expected counts deeper than this, 0 to run them all. */
+  int m_maxDepth{ 0 };
+
+  /* Count with perftChecksum, to compare the suite's checksum with another move generator's. */
+  bool m_checksum{ false };
+};
+
+/*
+ * Parse a line of a suite, returning nullopt if it is malformed. FENs without the move counters
+ * are accepted, as they are left out by some suites.
+ */
+auto parseEpdLine(std::string_view line) -> std::optional<EpdPosition>;
+
+/*
+ * Perft a position at each of its depths in turn, up to maxDepth (0 for all of them), stopping at
+ * the first count that is not as expected. Runs on the calling thread. With checksum the nodes are
+ * counted by perftChecksum, which is much slower.
+ */
+auto runEpdPosition(const EpdPosition& position, int maxDepth, bool checksum = false) -> EpdResult;
+
+/*
+ * Run every position of a suite, several at once on the shared thread pool. Lines are read from
+ * input as positions are started, so the suite is never held in memory. Blank lines and comments
+ * (starting with #) are skipped.
+ *
+ * report is called with the result of each position as it finishes, one call at a time, so
+ * results arrive in order of completion rather than the order of the suite.
+ */
+auto runEpdSuite(std::istream& input,
+                 const EpdSuiteOptions& options,
+                 const std::function<void(const EpdResult&)>& report) -> EpdSummary;
+
+} // namespace yak
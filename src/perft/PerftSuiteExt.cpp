@@ -0,0 +1,206 @@
+#include "Perft.h"
+#include "PerftCommandLine.h"
+#include "PerftSuite.h"
+
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <string_view>
+
+namespace {
+
+void printUsage()
+{
+  std::cout << "\nPerftSuite: Check perft counts for every position of an EPD suite\n\n";
+  std::cout << "Usage:\n";
+  std::cout << "PerftSuite <file> [options]\n\n";
+  std::cout << "Each line of the file holds a FEN followed by the expected counts, e.g. \"<fen> ;D1 20 ;D2 400\".\n";
+  std::cout << "Use - as the file to read from standard input.\n\n";
+  std::cout << "Options:\n";
+  std::cout << "  --threads <n>    Number of positions to run at once (default: one per hardware thread)\n";
+  std::cout << "  --max-depth <n>  Skip expected counts deeper than this (default: run them all)\n";
+  std::cout << "  --json           Print a JSON object per line rather than text\n";
+  std::cout << "  --checksum       Also sum the hashes of the leaf positions, to compare with another move generator\n";
+}
+
+auto nodesPerSecond(uint64_t nodes, double seconds) -> double
+{
+  return (seconds > 0.0) ? static_cast<double>(nodes) / seconds : 0.0;
+}
+
+auto hex(uint64_t value) -> std::string
+{
+  std::ostringstream text;
+  text << "0x" << std::hex << std::setw(16) << std::setfill('0') << value;
+  return text.str();
+}
+
+auto jsonString(std::string_view text) -> std::string
+{
+  std::string quoted{ "\"" };
+  for (char c : text)
+  {
+    if (c == '"' || c == '\\') quoted += '\\';
+    quoted += c;
+  }
+  return quoted + "\"";
+}
+
+void printText(const yak::EpdResult& result, bool checksum)
+{
+  std::ostringstream line;
+  line << std::fixed << std::setprecision(3);
+  line << "line " << result.m_position.m_line << ": ";
+
+  if (result.m_passed)
+  {
+    line << "ok D" << result.m_depth << ", " << result.m_nodes << " nodes in " << result.m_seconds << " s ("
+         << std::setprecision(2) << nodesPerSecond(result.m_nodes, result.m_seconds) / 1e6 << " Mnps)";
+  }
+  else
+  {
+    line << "FAILED " << result.m_error;
+  }
+
+  if (checksum && result.m_passed) line << ", checksum " << hex(result.m_checksum);
+
+  line << "  " << result.m_position.m_fen << "\n";
+  std::cout << line.str() << std::flush;
+}
+
+void printJson(const yak::EpdResult& result, bool checksum)
+{
+  std::ostringstream line;
+  line << "{\"line\":" << result.m_position.m_line
+       << ",\"fen\":" << jsonString(result.m_position.m_fen)
+       << ",\"passed\":" << (result.m_passed ? "true" : "false")
+       << ",\"depth\":" << result.m_depth
+       << ",\"nodes\":" << result.m_nodes
+       << ",\"seconds\":" << result.m_seconds
+       << ",\"nps\":" << static_cast<uint64_t>(nodesPerSecond(result.m_nodes, result.m_seconds));
+
+  if (checksum && result.m_passed)
+  {
+    line << ",\"checksum\":" << jsonString(hex(result.m_checksum));
+  }
+
+  if (not result.m_passed)
+  {
+    line << ",\"error\":" << jsonString(result.m_error);
+  }
+
+  line << "}\n";
+  std::cout << line.str() << std::flush;
+}
+
+} // namespace
+
+int main(int argv, char** argc)
+{
+  if (argv < 2)
+  {
+    printUsage();
+    return 0;
+  }
+
+  yak::EpdSuiteOptions options{};
+  bool json{ false };
+
+  for (int i = 2; i < argv; ++i)
+  {
+    const std::string_view option{ argc[i] };
+
+    if (option == "--json")
+    {
+      json = true;
+      continue;
+    }
+
+    if (option == "--checksum")
+    {
+      options.m_checksum = true;
+      continue;
+    }
+
+    if (i + 1 >= argv)
+    {
+      std::cerr << "Missing value for option: " << option << "\n";
+      return 1;
+    }
+
+    if (option == "--threads")
+    {
+      auto threads = yak::parsePositive("threads", argc[++i], 1);
+      if (not threads) return 1;
+      options.m_threads = *threads;
+    }
+    else if (option == "--max-depth")
+    {
+      auto maxDepth = yak::parsePositive("max depth", argc[++i], 1);
+      if (not maxDepth) return 1;
+      options.m_maxDepth = *maxDepth;
+    }
+    else
+    {
+      std::cerr << "Unknown option: " << option << "\n";
+      printUsage();
+      return 1;
+    }
+  }
+
+  // Size the shared pool before it is first used
+  yak::ThreadPool::shared(options.m_threads);
+
+  std::ifstream file;
+  const std::string_view path{ argc[1] };
+  if (path != "-")
+  {
+    file.open(argc[1]);
+    if (not file)
+    {
+      std::cerr << "Could not open suite: " << path << "\n";
+      return 1;
+    }
+  }
+
+  std::istream& input = (path == "-") ? std::cin : file;
+
+  auto report = [json, checksum = options.m_checksum](const yak::EpdResult& result)
+  {
+    if (json) printJson(result, checksum);
+    else printText(result, checksum);
+  };
+
+  const auto summary = yak::runEpdSuite(input, options, report);
+  const auto nps = nodesPerSecond(summary.m_nodes, summary.m_seconds);
+
+  if (json)
+  {
+    std::cout << "{\"summary\":{\"positions\":" << summary.m_positions
+              << ",\"passed\":" << summary.m_positions - summary.m_failed
+              << ",\"failed\":" << summary.m_failed
+              << ",\"nodes\":" << summary.m_nodes
+              << ",\"seconds\":" << summary.m_seconds
+              << ",\"nps\":" << static_cast<uint64_t>(nps);
+
+    if (options.m_checksum) std::cout << ",\"checksum\":" << jsonString(hex(summary.m_checksum));
+
+    std::cout << "}}\n";
+  }
+  else
+  {
+    std::cout << std::fixed << std::setprecision(3);
+    std::cout << "\n Positions: " << summary.m_positions << ", passed: " << summary.m_positions - summary.m_failed
+              << ", failed: " << summary.m_failed << "\n";
+    std::cout << " Nodes: " << summary.m_nodes << " in " << summary.m_seconds << " s ("
+              << std::setprecision(2) << nps / 1e6 << " Mnps)\n";
+
+    if (options.m_checksum) std::cout << " Checksum: " << hex(summary.m_checksum) << "\n";
+
+    std::cout << "\n";
+  }
+
+  return summary.m_failed ? 1 : 0;
+}
@@ -3,8 +3,27 @@
 
 #include <board.h>
 #include <perft/Perft.h>
+#include <perft/PerftCheckpoint.h>
+#include <perft/PerftCommandLine.h>
+#include <perft/PerftDistributed.h>
+#include <perft/PerftHashTable.h>
+#include <perft/PerftSuite.h>
 
+#include <algorithm>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <future>
 #include <memory>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <sys/wait.h>
+#include <unistd.h>
 
 #define CATCH_CONFIG_ENABLE_BENCHMARKING
 
@@ -72,6 +91,508 @@ TEST_CASE("Perft Test")
 
 }
 
+TEST_CASE("Work stealing perft matches the serial count")
+{
+  Board board{ "r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq - 0 1" };
+
+  const auto serial = perftHelper(board, 3);
+
+  for (size_t threads : { 1, 2, 3, 8 })
+  {
+    for (int splitDepth : { 1, 2, 3 })
+    {
+      PerftOptions options{};
+      options.m_threads = threads;
+      options.m_splitDepth = splitDepth;
+
+      const auto result = perft(board, 3, options);
+      CHECK(result.m_total == serial.m_total);
+      CHECK(result.m_captures == serial.m_captures);
+    }
+  }
+
+  // The board is left as it was found
+  CHECK(board.toFen() == "r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq - 0 1");
+}
+
+TEST_CASE("Divide counts each root move in generation order")
+{
+  Board board{ "r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq - 0 1" };
+
+  PerftOptions options{};
+  options.m_threads = 3;
+
+  const auto divide = perftDivide(board, 3, options);
+  const auto moves = board.generateMoves();
+
+  REQUIRE(divide.size() == moves.size());
+
+  size_t total{ 0 };
+  for (size_t i = 0; i < moves.size(); ++i)
+  {
+    CHECK(divide[i].first == moves[i]);
+
+    board.makeMove(moves[i]);
+    CHECK(divide[i].second.m_total == perftHelper(board, 2).m_total);
+    board.undoMove();
+
+    total += divide[i].second.m_total;
+  }
+
+  CHECK(total == perft(board, 3).m_total);
+}
+
+TEST_CASE("Hashed perft matches the unhashed count")
+{
+  Board board{ "r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq - 0 1" };
+
+  PerftOptions options{};
+  options.m_threads = 2;
+  options.m_hashMegabytes = 1;
+
+  CHECK(perft(board, 4, options).m_total == 4085603);
+
+  PerftHashTable table{ 1 };
+  CHECK(perftHashed(board, 4, table) == 4085603);
+  CHECK(perftHashed(board, 4, table) == 4085603);
+  CHECK(perftTotal(board, 4) == 4085603);
+}
+
+namespace {
+
+void checkResult(const PerftResult& result, const PerftResult& expected)
+{
+  CHECK(result.m_total == expected.m_total);
+  CHECK(result.m_captures == expected.m_captures);
+  CHECK(result.m_ep == expected.m_ep);
+  CHECK(result.m_castles == expected.m_castles);
+  CHECK(result.m_promotions == expected.m_promotions);
+  CHECK(result.m_checks == expected.m_checks);
+  CHECK(result.m_checkmates == expected.m_checkmates);
+}
+
+} // namespace
+
+TEST_CASE("Perft counts every kind of move")
+{
+  // Expected results are from the Chess Programming Wiki perft results page
+  SECTION("Initial position")
+  {
+    Board board{ "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1" };
+    checkResult(perft(board, 4), PerftResult{ 197281, 1576, 0, 0, 0, 469, 8 });
+    checkResult(perft(board, 5), PerftResult{ 4865609, 82719, 258, 0, 0, 27351, 347 });
+  }
+
+  SECTION("Kiwipete")
+  {
+    Board board{ "r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq - 0 1" };
+    checkResult(perft(board, 1), PerftResult{ 48, 8, 0, 2, 0, 0, 0 });
+    checkResult(perft(board, 2), PerftResult{ 2039, 351, 1, 91, 0, 3, 0 });
+    checkResult(perft(board, 3), PerftResult{ 97862, 17102, 45, 3162, 0, 993, 1 });
+    checkResult(perft(board, 4), PerftResult{ 4085603, 757163, 1929, 128013, 15172, 25523, 43 });
+  }
+
+  SECTION("Position 3")
+  {
+    Board board{ "8/2p5/3p4/KP5r/1R3p1k/8/4P1P1/8 w - - 0 1" };
+    checkResult(perft(board, 5), PerftResult{ 674624, 52051, 1165, 0, 0, 52950, 0 });
+  }
+
+  SECTION("Position 4")
+  {
+    Board board{ "r3k2r/Pppp1ppp/1b3nbN/nP6/BBP1P3/q4N2/Pp1P2PP/R2Q1RK1 w kq - 0 1" };
+    checkResult(perft(board, 4), PerftResult{ 422333, 131393, 0, 7795, 60032, 15492, 5 });
+  }
+}
+
+TEST_CASE("Perft checksum sums the leaves in any order")
+{
+  Board board{ "r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq - 0 1" };
+
+  const auto checksum = perftChecksum(board, 3);
+  CHECK(checksum.m_nodes == 97862);
+
+  // The same leaves visited a root move at a time, in reverse generation order
+  uint64_t leafHashSum{ 0 };
+  uint64_t nodes{ 0 };
+  auto moves = board.generateMoves();
+  std::reverse(moves.begin(), moves.end());
+  for (const auto& move : moves)
+  {
+    board.makeMove(move);
+    const auto child = perftChecksum(board, 2);
+    leafHashSum += child.m_leafHashSum;
+    nodes += child.m_nodes;
+    (void) board.undoMove();
+  }
+
+  CHECK(nodes == checksum.m_nodes);
+  CHECK(leafHashSum == checksum.m_leafHashSum);
+
+  // Each ply's histogram covers every position at that ply, and sums to the moves out of them
+  REQUIRE(checksum.m_moveCounts.size() == 3);
+  CHECK(checksum.m_moveCounts[0].size() == 49);
+  CHECK(checksum.m_moveCounts[0][48] == 1);
+
+  const uint64_t positions[]{ 1, 48, 2039, 97862 };
+  for (size_t ply = 0; ply < 3; ++ply)
+  {
+    uint64_t counted{ 0 }, moveTotal{ 0 };
+    for (size_t moveCount = 0; moveCount < checksum.m_moveCounts[ply].size(); ++moveCount)
+    {
+      counted += checksum.m_moveCounts[ply][moveCount];
+      moveTotal += moveCount * checksum.m_moveCounts[ply][moveCount];
+    }
+
+    CHECK(counted == positions[ply]);
+    CHECK(moveTotal == positions[ply + 1]);
+  }
+
+  // Transposed move orders reach the same position, and so the same leaves
+  auto play = [](Board& game, std::initializer_list<std::string_view> line)
+  {
+    for (auto played : line)
+    {
+      const auto legal = game.generateMoves();
+      const auto move = std::find_if(legal.begin(), legal.end(), [&](Move m) { return toAlgebraic(m) == played; });
+      REQUIRE(move != legal.end());
+      game.makeMove(*move);
+    }
+  };
+
+  Board first{ "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1" };
+  Board second{ "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1" };
+  play(first, { "g1f3", "g8f6", "b1c3" });
+  play(second, { "b1c3", "g8f6", "g1f3" });
+  CHECK(perftChecksum(first, 0) == perftChecksum(second, 0));
+  CHECK(perftChecksum(first, 3) == perftChecksum(second, 3));
+  CHECK(perftChecksum(first, 3) != perftChecksum(board, 3));
+}
+
+TEST_CASE("Perft progress counts every unit")
+{
+  Board board{ "r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq - 0 1" };
+
+  PerftProgress progress{ 2 };
+  CHECK(progress.snapshot().m_units == 0);
+
+  PerftOptions options{};
+  options.m_threads = 2;
+  options.m_progress = &progress;
+
+  CHECK(perft(board, 3, options).m_total == 97862);
+
+  const auto snapshot = progress.snapshot();
+  CHECK(snapshot.m_nodes == 97862);
+  CHECK(snapshot.m_units == 2039);
+  CHECK(snapshot.m_unitsDone == 2039);
+  CHECK(snapshot.m_estimatedNodes == 97862);
+  REQUIRE(snapshot.m_utilisation.size() == 2);
+
+  // Either worker may have stolen every unit, so only the pair is certain to have been busy
+  CHECK(snapshot.m_utilisation[0] + snapshot.m_utilisation[1] > 0.0);
+  CHECK(snapshot.m_utilisation[0] <= 1.0);
+  CHECK(snapshot.m_utilisation[1] <= 1.0);
+}
+
+TEST_CASE("Perft progress estimates the units left by their legal moves")
+{
+  PerftProgress progress{ 1 };
+
+  // A unit in check with 2 replies and one with 40, where the small one finishes first
+  progress.start(2, 42);
+  CHECK(progress.snapshot().m_estimatedNodes == 0);
+
+  progress.unitStarted(0);
+  progress.unitFinished(0, 2, 60);
+
+  // 30 nodes per move, rather than the 60 of the only finished unit
+  CHECK(progress.snapshot().m_estimatedNodes == 60 + 40 * 30);
+
+  progress.unitStarted(0);
+  progress.unitFinished(0, 40, 1000);
+  CHECK(progress.snapshot().m_estimatedNodes == 1060);
+}
+
+TEST_CASE("Checkpointed perft resumes from the finished units")
+{
+  const std::string fen{ "r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq - 0 1" };
+  const auto path = (std::filesystem::temp_directory_path() / "yak-perft-checkpoint-test").string();
+  std::filesystem::remove(path);
+
+  Board board{ fen };
+  const auto expected = perft(board, 3);
+
+  std::string error;
+  auto checkpoint = PerftCheckpoint::open(path, fen, 3, false, error);
+  REQUIRE(checkpoint);
+
+  PerftOptions options{};
+  options.m_threads = 2;
+  options.m_checkpoint = checkpoint.get();
+  CHECK(perft(board, 3, options).m_checkmates == expected.m_checkmates);
+
+  const size_t units = checkpoint->size();
+  CHECK(units == 2039);
+  checkpoint.reset();
+
+  // Stop part of the way through, with the last unit only half written
+  std::vector<std::string> lines;
+  {
+    std::ifstream file{ path };
+    for (std::string line; std::getline(file, line);) lines.push_back(line);
+  }
+
+  {
+    std::ofstream file{ path, std::ios::trunc };
+    for (size_t i = 0; i < 1000; ++i) file << lines[i] << "\n";
+    file << lines[1000].substr(0, lines[1000].size() - 4);
+  }
+
+  checkpoint = PerftCheckpoint::open(path, fen, 3, false, error);
+  REQUIRE(checkpoint);
+  CHECK(checkpoint->size() == 1000 - 4);
+
+  options.m_checkpoint = checkpoint.get();
+  const auto resumed = perft(board, 3, options);
+  CHECK(resumed.m_total == expected.m_total);
+  CHECK(resumed.m_captures == expected.m_captures);
+  CHECK(resumed.m_checks == expected.m_checks);
+  CHECK(checkpoint->size() == units);
+  checkpoint.reset();
+
+  // A checkpoint can only resume the run it was made for
+  CHECK_FALSE(PerftCheckpoint::open(path, fen, 4, false, error));
+  CHECK_FALSE(error.empty());
+
+  // A hashed run counts only the totals, so it can't resume a run with full counts, or be resumed
+  // by one
+  error.clear();
+  CHECK_FALSE(PerftCheckpoint::open(path, fen, 3, true, error));
+  CHECK_FALSE(error.empty());
+
+  std::filesystem::remove(path);
+  REQUIRE(PerftCheckpoint::open(path, fen, 3, true, error));
+
+  error.clear();
+  CHECK_FALSE(PerftCheckpoint::open(path, fen, 3, false, error));
+  CHECK_FALSE(error.empty());
+
+  std::filesystem::remove(path);
+}
+
+TEST_CASE("Distributed perft re-issues the units of lost workers")
+{
+  const std::string fen{ "r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq - 0 1" };
+  const auto path = (std::filesystem::temp_directory_path() / "yak-perft-distributed-test.sock").string();
+
+  Board board{ fen };
+  const auto expected = perftDivide(board, 4);
+
+  DistributedOptions options{};
+  options.m_address = "unix:" + path;
+  options.m_splitDepth = 2;
+
+  auto coordinator = std::async(std::launch::async, [&] { return perftCoordinator(board, 4, options); });
+
+  // A worker that takes a unit and then dies without counting it
+  {
+    sockaddr_un address{};
+    address.sun_family = AF_UNIX;
+    std::memcpy(address.sun_path, path.c_str(), path.size());
+
+    int fd{ -1 };
+    for (int attempt = 0; attempt < 100 && fd < 0; ++attempt)
+    {
+      fd = ::socket(AF_UNIX, SOCK_STREAM, 0);
+      if (::connect(fd, reinterpret_cast<sockaddr*>(&address), sizeof(address)) != 0)
+      {
+        ::close(fd);
+        fd = -1;
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+      }
+    }
+
+    REQUIRE(fd >= 0);
+
+    char unit[256];
+    CHECK(::recv(fd, unit, sizeof(unit), 0) > 0);
+    ::close(fd);
+  }
+
+  PerftOptions workerOptions{};
+  workerOptions.m_threads = 1;
+
+  auto first = std::async(std::launch::async, [&] { return perftWorker(options.m_address, workerOptions, 1.0); });
+  auto second = std::async(std::launch::async, [&] { return perftWorker(options.m_address, workerOptions, 1.0); });
+
+  const auto divide = coordinator.get();
+
+  // One of the workers may only have got going after the other had counted every unit, and so
+  // never found the coordinator.
+  const bool firstFinished = first.get();
+  const bool secondFinished = second.get();
+  CHECK((firstFinished || secondFinished));
+
+  REQUIRE(divide.size() == expected.size());
+  for (size_t i = 0; i < divide.size(); ++i)
+  {
+    CHECK(divide[i].first == expected[i].first);
+    CHECK(divide[i].second.m_total == expected[i].second.m_total);
+    CHECK(divide[i].second.m_checks == expected[i].second.m_checks);
+  }
+}
+
+namespace {
+
+/* Run PerftExt with the arguments in a child process, returning its exit code, or -1 if it didn't exit. */
+auto runPerftExt(std::vector<std::string> arguments) -> int
+{
+  arguments.insert(arguments.begin(), YAK_PERFT_EXT_PATH);
+
+  std::vector<char*> argv;
+  for (auto& argument : arguments) argv.push_back(argument.data());
+  argv.push_back(nullptr);
+
+  const pid_t pid = ::fork();
+  if (pid == 0)
+  {
+    ::execv(argv[0], argv.data());
+    ::_exit(127);
+  }
+
+  int status{ 0 };
+  if (pid < 0 || ::waitpid(pid, &status, 0) != pid) return -1;
+  return WIFEXITED(status) ? WEXITSTATUS(status) : -1;
+}
+
+} // namespace
+
+TEST_CASE("Distributed perft counts with worker processes")
+{
+  const std::string fen{ "r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq - 0 1" };
+  const auto path = (std::filesystem::temp_directory_path() / "yak-perft-process-test.sock").string();
+
+  Board board{ fen };
+  const auto expected = perftDivide(board, 4);
+
+  DistributedOptions options{};
+  options.m_address = "unix:" + path;
+  options.m_splitDepth = 2;
+
+  auto coordinator = std::async(std::launch::async, [&] { return perftCoordinator(board, 4, options); });
+
+  // Workers given options they would ignore stop before taking any units
+  CHECK(runPerftExt({ "--worker", options.m_address, "--checkpoint", "unused.checkpoint" }) == 1);
+  CHECK(runPerftExt({ "--worker", options.m_address, "--progress", "1" }) == 1);
+
+  const int exitCode = runPerftExt({ "--worker", options.m_address, "--threads", "2" });
+
+  // Finish the run on this process if the worker didn't, so that the coordinator returns
+  if (exitCode != 0)
+  {
+    PerftOptions workerOptions{};
+    workerOptions.m_threads = 1;
+    perftWorker(options.m_address, workerOptions, 1.0);
+  }
+
+  const auto divide = coordinator.get();
+  CHECK(exitCode == 0);
+
+  REQUIRE(divide.size() == expected.size());
+  for (size_t i = 0; i < divide.size(); ++i)
+  {
+    CHECK(divide[i].first == expected[i].first);
+    CHECK(divide[i].second.m_total == expected[i].second.m_total);
+    CHECK(divide[i].second.m_checkmates == expected[i].second.m_checkmates);
+  }
+}
+
+TEST_CASE("Coordinators reject the options only workers use")
+{
+  const std::string fen{ "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1" };
+  const std::string address{ "unix:" + (std::filesystem::temp_directory_path() / "yak-perft-unused.sock").string() };
+
+  // Otherwise these would wait for workers that never come
+  CHECK(runPerftExt({ "3", fen, "--coordinator", address, "--threads", "2" }) == 1);
+  CHECK(runPerftExt({ "3", fen, "--coordinator", address, "--hash", "16" }) == 1);
+}
+
+TEST_CASE("EPD suite lines are parsed with their expected counts")
+{
+  auto position = parseEpdLine("rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1 ;D2 400 ;D1 20 ;id \"start\"");
+  REQUIRE(position);
+  CHECK(position->m_fen == "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1");
+  CHECK(position->m_expected == std::vector<std::pair<int, uint64_t>>{ { 1, 20 }, { 2, 400 } });
+
+  // The move counters are optional
+  position = parseEpdLine("4k3/8/8/8/8/8/8/4K2R w K - ;D1 15");
+  REQUIRE(position);
+  CHECK(position->m_fen == "4k3/8/8/8/8/8/8/4K2R w K - 0 1");
+
+  CHECK_FALSE(parseEpdLine("4k3/8/8/8/8/8/8/4K2R w K - 0 1"));
+  CHECK_FALSE(parseEpdLine("4k3/8/8/8/8/8/8/4K2R w K - 0 1 ;D1 fifteen"));
+  CHECK_FALSE(parseEpdLine("4k3/8/8/8/8/8/8/4K2R w ;D1 15"));
+}
+
+TEST_CASE("EPD suite reports each position")
+{
+  std::istringstream suite{
+    "# Positions from the Chess Programming Wiki\n"
+    "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1 ;D1 20 ;D2 400 ;D3 8902\n"
+    "\n"
+    "8/2p5/3p4/KP5r/1R3p1k/8/4P1P1/8 w - - 0 1 ;D1 14 ;D2 191 ;D3 2812\n"
+    "r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq - 0 1 ;D1 48 ;D2 2040 ;D3 97862\n"
+    "not a position\n" };
+
+  EpdSuiteOptions options{};
+  options.m_threads = 2;
+
+  std::vector<EpdResult> results;
+  const auto summary = runEpdSuite(suite, options, [&results](const EpdResult& result) { results.push_back(result); });
+
+  CHECK(summary.m_positions == 4);
+  CHECK(summary.m_failed == 2);
+  CHECK(summary.m_nodes == 20 + 400 + 8902 + 14 + 191 + 2812 + 48 + 2039);
+
+  REQUIRE(results.size() == 4);
+  std::sort(results.begin(), results.end(), [](const auto& a, const auto& b) { return a.m_position.m_line < b.m_position.m_line; });
+
+  CHECK(results[0].m_position.m_line == 2);
+  CHECK(results[0].m_passed);
+  CHECK(results[0].m_depth == 3);
+
+  CHECK(results[1].m_position.m_line == 4);
+  CHECK(results[1].m_passed);
+
+  // Counting stops at the first wrong depth
+  CHECK(results[2].m_position.m_line == 5);
+  CHECK_FALSE(results[2].m_passed);
+  CHECK(results[2].m_depth == 2);
+  CHECK(results[2].m_error == "D2 expected 2040, counted 2039");
+
+  CHECK(results[3].m_position.m_line == 6);
+  CHECK_FALSE(results[3].m_passed);
+
+  // Deeper counts can be skipped
+  options.m_maxDepth = 1;
+  suite.clear();
+  suite.str("r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq - 0 1 ;D1 48 ;D2 2040\n");
+  CHECK(runEpdSuite(suite, options, [](const EpdResult&) {}).m_failed == 0);
+}
+
+TEST_CASE("Numeric options are parsed down to their minimum")
+{
+  CHECK(parsePositive("threads", "4", 1) == 4);
+  CHECK(parsePositive("threads", "1", 1) == 1);
+  CHECK_FALSE(parsePositive("threads", "0", 1));
+  CHECK_FALSE(parsePositive("threads", "four", 1));
+  CHECK_FALSE(parsePositive("threads", "8abc", 1));
+  CHECK_FALSE(parsePositive("depth", "4x", 1));
+  CHECK_FALSE(parsePositive("depth", "", 1));
+  CHECK_FALSE(parsePositive("depth", "99999999999", 1));
+}
+
 TEST_CASE("Perft Test", "[benchmark]")
 {
   PerftResult result;
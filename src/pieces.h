@@ -44,66 +44,62 @@ private:
 
 /**
  * \brief Attack map for a knight on a given square.
- * \tparam S - The square the the knight is on.
+ * \param[in] square - The square the knight is on.
  */
-template<Square S>
-struct knight_map
+constexpr Bitboard knightAttacks(Square square)
 {
-  static constexpr Bitboard
-    value = bitboard::shift<Direction::NORTH>(bitboard::shift<Direction::NORTH_EAST>(bitboard::static_bitboard<S>::value))
-    | bitboard::shift<Direction::NORTH>(bitboard::shift<Direction::NORTH_WEST>(bitboard::static_bitboard<S>::value))
-    | bitboard::shift<Direction::EAST>(bitboard::shift<Direction::NORTH_EAST>(bitboard::static_bitboard<S>::value))
-    | bitboard::shift<Direction::EAST>(bitboard::shift<Direction::SOUTH_EAST>(bitboard::static_bitboard<S>::value))
-    | bitboard::shift<Direction::SOUTH>(bitboard::shift<Direction::SOUTH_EAST>(bitboard::static_bitboard<S>::value))
-    | bitboard::shift<Direction::SOUTH>(bitboard::shift<Direction::SOUTH_WEST>(bitboard::static_bitboard<S>::value))
-    | bitboard::shift<Direction::WEST>(bitboard::shift<Direction::SOUTH_WEST>(bitboard::static_bitboard<S>::value))
-    | bitboard::shift<Direction::WEST>(bitboard::shift<Direction::NORTH_WEST>(bitboard::static_bitboard<S>::value));
-};
+  const Bitboard square_bb = Bitboard{1} << square;
+
+  return bitboard::shift<Direction::NORTH>(bitboard::shift<Direction::NORTH_EAST>(square_bb))
+    | bitboard::shift<Direction::NORTH>(bitboard::shift<Direction::NORTH_WEST>(square_bb))
+    | bitboard::shift<Direction::EAST>(bitboard::shift<Direction::NORTH_EAST>(square_bb))
+    | bitboard::shift<Direction::EAST>(bitboard::shift<Direction::SOUTH_EAST>(square_bb))
+    | bitboard::shift<Direction::SOUTH>(bitboard::shift<Direction::SOUTH_EAST>(square_bb))
+    | bitboard::shift<Direction::SOUTH>(bitboard::shift<Direction::SOUTH_WEST>(square_bb))
+    | bitboard::shift<Direction::WEST>(bitboard::shift<Direction::SOUTH_WEST>(square_bb))
+    | bitboard::shift<Direction::WEST>(bitboard::shift<Direction::NORTH_WEST>(square_bb));
+}
 
 /**
  * \brief Attack map for a king on a given square.
- * \tparam S - The square the the king is on.
+ * \param[in] square - The square the king is on.
  */
-template<Square S>
-struct king_map
+constexpr Bitboard kingAttacks(Square square)
 {
-  static constexpr Bitboard value = bitboard::shift<Direction::NORTH>(bitboard::static_bitboard<S>::value)
-    | bitboard::shift<Direction::EAST>(bitboard::static_bitboard<S>::value)
-    | bitboard::shift<Direction::SOUTH>(bitboard::static_bitboard<S>::value)
-    | bitboard::shift<Direction::WEST>(bitboard::static_bitboard<S>::value)
-    | bitboard::shift<Direction::NORTH_EAST>(bitboard::static_bitboard<S>::value)
-    | bitboard::shift<Direction::NORTH_WEST>(bitboard::static_bitboard<S>::value)
-    | bitboard::shift<Direction::SOUTH_EAST>(bitboard::static_bitboard<S>::value)
-    | bitboard::shift<Direction::SOUTH_WEST>(bitboard::static_bitboard<S>::value);
-};
+  const Bitboard square_bb = Bitboard{1} << square;
+
+  return bitboard::shift<Direction::NORTH>(square_bb)
+    | bitboard::shift<Direction::EAST>(square_bb)
+    | bitboard::shift<Direction::SOUTH>(square_bb)
+    | bitboard::shift<Direction::WEST>(square_bb)
+    | bitboard::shift<Direction::NORTH_EAST>(square_bb)
+    | bitboard::shift<Direction::NORTH_WEST>(square_bb)
+    | bitboard::shift<Direction::SOUTH_EAST>(square_bb)
+    | bitboard::shift<Direction::SOUTH_WEST>(square_bb);
+}
 
-template<PieceType Type, Square S>
+template<PieceType Type>
 requires Jumpable<Type>
-constexpr Bitboard jumpingPieceMap()
+consteval auto buildJumpMap() -> std::array<Bitboard, 64>
 {
-  if constexpr (Type == PieceType::KNIGHT)
+  std::array<Bitboard, 64> map{};
+
+  for (int square = A1; square <= H8; ++square)
   {
-    return knight_map<S>::value;
+    map[square] = (Type == PieceType::KNIGHT) ? knightAttacks(static_cast<Square>(square))
+                                              : kingAttacks(static_cast<Square>(square));
   }
 
-  return king_map<S>::value;
+  return map;
 }
 
 /**
  * \brief Static table of jumping piece attacks.
  */
-template<PieceType T, Square S = A1, Bitboard... B>
-struct jump_map : jump_map<T,
-                           static_cast<Square>(S + 1),
-                           B...,
-                           jumpingPieceMap<T, S>()>
-{
-};
-
-template<PieceType T, Bitboard... B>
-struct jump_map<T, H8, B...>
+template<PieceType T>
+struct jump_map
 {
-  static constexpr std::array<Bitboard, 64> value = {B...};
+  static constexpr std::array<Bitboard, 64> value = buildJumpMap<T>();
 };
 
 constexpr std::array<Bitboard, 64> knightMap = jump_map<PieceType::KNIGHT>::value;
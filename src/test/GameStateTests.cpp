@@ -170,6 +170,27 @@ TEST_CASE("Game stack tests")
   CHECK_FALSE(move_p);
 }
 
+TEST_CASE("Popped states are reused, fresh, by later moves")
+{
+  GameStateManager gs{};
+
+  gs.update(makeDoublePush(E2, E4));
+  const GameState* first = gs.operator->();
+  CHECK(gs->epTargetSquare() == E3);
+
+  REQUIRE(gs.pop());
+
+  // The released state is handed out again, with nothing left over from its last use
+  gs.update(makeQuiet(G1, F3, PieceType::KNIGHT));
+  CHECK(gs.operator->() == first);
+  CHECK(gs->epTargetSquare() == NULL_SQUARE);
+  CHECK(gs->sideToMove() == PieceColour::BLACK);
+  CHECK(gs->halfMoveClock() == 1);
+
+  REQUIRE(gs.pop());
+  CHECK(gs->sideToMove() == PieceColour::WHITE);
+}
+
 TEST_CASE("Check that the EP square works")
 {
   GameStateManager state{};
@@ -258,7 +279,7 @@ TEST_CASE("Check that the EP square works")
 TEST_CASE("Check that the move clock works")
 {
   GameStateManager state{};
-  Move move;
+  Move move{};
 
   CHECK(state->sideToMove() == PieceColour::WHITE);
   CHECK(state->sideNotToMove() == PieceColour::BLACK);
@@ -0,0 +1,56 @@
+#include <catch2/catch_test_macros.hpp>
+
+#include <LargeBuffer.h>
+
+#include <cstdint>
+#include <cstring>
+#include <utility>
+
+namespace yak::memory {
+
+TEST_CASE("Small buffers are cache line aligned and use normal pages")
+{
+  LargeBuffer buffer{ 1000 };
+
+  REQUIRE(buffer.data() != nullptr);
+  CHECK(buffer.size() == 1000);
+  CHECK(reinterpret_cast<std::uintptr_t>(buffer.data()) % CACHE_LINE_SIZE == 0);
+  CHECK(buffer.pageMode() == PageMode::NORMAL_PAGES);
+
+  std::memset(buffer.data(), 0xff, buffer.size());
+}
+
+TEST_CASE("Large buffers use huge pages when they are supported")
+{
+  LargeBuffer buffer{ HUGE_PAGE_SIZE + 12345 };
+
+  REQUIRE(buffer.data() != nullptr);
+  CHECK(reinterpret_cast<std::uintptr_t>(buffer.data()) % CACHE_LINE_SIZE == 0);
+
+  if (buffer.pageMode() == PageMode::HUGE_PAGES)
+  {
+    CHECK(hugePageSupport().enabled);
+    CHECK(reinterpret_cast<std::uintptr_t>(buffer.data()) % HUGE_PAGE_SIZE == 0);
+  }
+
+  // The whole of the buffer must be writable, including the partial huge page at the end.
+  std::memset(buffer.data(), 0xff, buffer.size());
+}
+
+TEST_CASE("Moving a buffer transfers ownership")
+{
+  LargeBuffer buffer{ 4096 };
+  void* data = buffer.data();
+
+  LargeBuffer moved{ std::move(buffer) };
+  CHECK(moved.data() == data);
+  CHECK(moved.size() == 4096);
+  CHECK(buffer.data() == nullptr);
+
+  LargeBuffer assigned;
+  assigned = std::move(moved);
+  CHECK(assigned.data() == data);
+  CHECK(moved.data() == nullptr);
+}
+
+} // namespace yak::memory
@@ -174,4 +174,51 @@ TEST_CASE("In between tests")
   CHECK(betweenSet<B6, B6>() == bitboard::EMPTY);
 }
 
+TEST_CASE("Line through two squares")
+{
+  // Squares (S)
+  //   Board                  Line through
+  // . . . . . . . .        . . . . . . . 1
+  // . . . . . . . .        . . . . . . 1 .
+  // . . . . . S . .        . . . . . 1 . .
+  // . . . . . . . .        . . . . 1 . . .
+  // . . . . . . . .        . . . 1 . . . .
+  // . . S . . . . .        . . 1 . . . . .
+  // . . . . . . . .        . 1 . . . . . .
+  // . . . . . . . .        1 . . . . . . .
+
+  CHECK(LineThrough::value[C3][F6] == bitboard::createBitboard(A1, B2, C3, D4, E5, F6, G7, H8));
+  CHECK(LineThrough::value[F6][C3] == LineThrough::value[C3][F6]);
+
+  CHECK(LineThrough::value[B5][F5] == bitboard::RANK_5);
+  CHECK(LineThrough::value[D2][D7] == bitboard::FILE_D);
+  CHECK(LineThrough::value[A3][C1] == bitboard::createBitboard(A3, B2, C1));
+
+  CHECK(LineThrough::value[F5][B6] == bitboard::EMPTY);
+  CHECK(LineThrough::value[B6][B6] == bitboard::EMPTY);
+
+  // The in between squares are always on the line through
+  for (int from = A1; from <= H8; ++from)
+  {
+    for (int to = A1; to <= H8; ++to)
+    {
+      const auto between_bb = InBetween::value[from][to];
+      CHECK((LineThrough::value[from][to] & between_bb) == between_bb);
+    }
+  }
+}
+
+TEST_CASE("Distances between squares")
+{
+  CHECK(distance(A1, A1) == 0);
+  CHECK(distance(A1, H8) == 7);
+  CHECK(distance(E4, F6) == 2);
+  CHECK(distance(B7, G7) == 5);
+
+  CHECK(manhattanDistance(A1, A1) == 0);
+  CHECK(manhattanDistance(A1, H8) == 14);
+  CHECK(manhattanDistance(E4, F6) == 3);
+  CHECK(manhattanDistance(H1, A8) == 14);
+}
+
 } // namespace yak
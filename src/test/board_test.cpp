@@ -9,6 +9,7 @@
 #include <string_view>
 #include <vector>
 #include <algorithm>
+#include <array>
 
 namespace yak {
 
@@ -661,4 +662,248 @@ TEST_CASE("Pin test")
   CHECK(board.getPinned<PieceColour::WHITE>() == bitboard::createBitboard(C3, C4, C5, D3, D5, E3, E4, E5));
   CHECK(board.getPinned<PieceColour::BLACK>() == bitboard::EMPTY);
 }
+
+namespace {
+
+// Walk the tree checking that the incrementally updated hash is the hash of the position.
+void checkHashes(Board& board, int depth)
+{
+  const auto hash = board.hash();
+  CHECK(hash == Board{ board.toFen() }.hash());
+
+  if (depth == 0) return;
+
+  for (const auto& move : board.generateMoves())
+  {
+    board.makeMove(move);
+    checkHashes(board, depth - 1);
+    board.undoMove();
+
+    CHECK(board.hash() == hash);
+  }
+}
+
+} // namespace
+
+TEST_CASE("Zobrist hash is updated by make and undo move")
+{
+  // Castling, en passant and promotions (with and without capture) are all reachable from these
+  Board board{ "r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq - 0 1" };
+  checkHashes(board, 2);
+
+  board.reset("n1n5/PPPk4/8/8/8/8/4Kppp/5N1N b - - 0 1");
+  checkHashes(board, 2);
+
+  board.reset("8/8/8/8/Pp6/1P6/8/8 b - a3 0 1");
+  checkHashes(board, 1);
+}
+
+TEST_CASE("A null move passes the move to the opponent")
+{
+  Board board{ "rnbqkbnr/ppp1pppp/8/8/3pP3/8/PPPP1PPP/RNBQKBNR b KQkq e3 0 1" };
+  const zobrist::Key hash = board.hash();
+  const auto moves = board.generateMoves();
+
+  board.makeNullMove();
+
+  // The castling rights are kept, the ep square is lost
+  CHECK(board.sideToMove() == PieceColour::WHITE);
+  CHECK(board.toFen() == "rnbqkbnr/ppp1pppp/8/8/3pP3/8/PPPP1PPP/RNBQKBNR w KQkq - 0 2");
+  CHECK(board.hash() == Board{ board.toFen() }.hash());
+
+  board.undoNullMove();
+
+  CHECK(board.hash() == hash);
+  CHECK(board.toFen() == "rnbqkbnr/ppp1pppp/8/8/3pP3/8/PPPP1PPP/RNBQKBNR b KQkq e3 0 1");
+  CHECK(board.generateMoves() == moves);
+}
+
+TEST_CASE("Zobrist hash distinguishes side to move, castling and ep")
+{
+  const auto hash = Board{ STANDARD_STARTING_FEN }.hash();
+
+  CHECK(hash != Board{ "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR b KQkq - 0 1" }.hash());
+  CHECK(hash != Board{ "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w Kkq - 0 1" }.hash());
+  CHECK(Board{ "8/8/8/8/Pp6/1P6/8/8 b - a3 0 1" }.hash() != Board{ "8/8/8/8/Pp6/1P6/8/8 b - - 0 1" }.hash());
+
+  // Transpositions reach the same hash
+  Board board{ STANDARD_STARTING_FEN };
+  board.makeMove(makeQuiet(G1, F3, PieceType::KNIGHT));
+  board.makeMove(makeQuiet(G8, F6, PieceType::KNIGHT));
+  board.makeMove(makeQuiet(F3, G1, PieceType::KNIGHT));
+  board.makeMove(makeQuiet(F6, G8, PieceType::KNIGHT));
+  CHECK(board.hash() == hash);
+}
+
+namespace {
+
+// Walk the tree checking that the bulk counts, and the checks found without making the moves, agree
+// with the generated moves.
+void checkMoveCounts(Board& board, int depth)
+{
+  const auto moves = board.generateMoves();
+
+  std::array<Move, MAX_MOVES> checkingMoves;
+  const auto counts = board.countLegalMoves(checkingMoves.data());
+
+  CHECK(counts.m_total == static_cast<int>(moves.size()));
+  CHECK(counts.m_captures == std::count_if(moves.begin(), moves.end(), [](Move move) { return isCapture(move); }));
+  CHECK(counts.m_ep == std::count_if(moves.begin(), moves.end(), [](Move move) { return isEnPassant(move); }));
+  CHECK(counts.m_castles == std::count_if(moves.begin(), moves.end(), [](Move move) { return isCastle(move); }));
+  CHECK(counts.m_promotions == std::count_if(moves.begin(), moves.end(), [](Move move) { return isPromotion(move); }));
+  CHECK(board.hasLegalMoves() == not moves.empty());
+
+  int checks{ 0 };
+  for (const auto& move : moves)
+  {
+    const bool givesCheck = board.givesCheck(move);
+
+    board.makeMove(move);
+    CHECK(givesCheck == board.isCheck());
+    if (givesCheck)
+    {
+      CHECK(std::find(checkingMoves.begin(), checkingMoves.begin() + counts.m_checks, move) != checkingMoves.begin() + counts.m_checks);
+      ++checks;
+    }
+
+    if (depth > 0) checkMoveCounts(board, depth - 1);
+    board.undoMove();
+  }
+
+  CHECK(counts.m_checks == checks);
+}
+
+} // namespace
+
+TEST_CASE("Legal move counts match the generated moves")
+{
+  // Positions 2 to 6 of the Chess Programming Wiki perft results, between them these cover checks,
+  // pins, en passant (including the horizontal pin), castling and promotions.
+  Board board{ "r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq - 0 1" };
+  checkMoveCounts(board, 2);
+
+  board.reset("8/2p5/3p4/KP5r/1R3p1k/8/4P1P1/8 w - - 0 1");
+  checkMoveCounts(board, 3);
+
+  board.reset("r3k2r/Pppp1ppp/1b3nbN/nP6/BBP1P3/q4N2/Pp1P2PP/R2Q1RK1 w kq - 0 1");
+  checkMoveCounts(board, 2);
+
+  board.reset("rnbq1k1r/pp1Pbppp/2p5/8/2B5/8/PPP1NnPP/RNBQK2R w KQ - 1 8");
+  checkMoveCounts(board, 2);
+
+  board.reset("r4rk1/1pp1qppp/p1np1n2/2b1p1B1/2B1P1b1/P1NP1N2/1PP1QPPP/R4RK1 w - - 0 10");
+  checkMoveCounts(board, 2);
+}
+
+namespace {
+
+Move findMove(Board& board, std::string_view from, std::string_view to, PieceType promoted = PieceType::NULL_PIECE)
+{
+  const auto moves = board.generateMoves();
+  const auto found = std::find_if(moves.begin(), moves.end(), [&](Move move) {
+    return toAlgebraic(yak::from(move)) == from && toAlgebraic(yak::to(move)) == to
+      && (not isPromotion(move) || promotion(move) == promoted);
+  });
+  REQUIRE(found != moves.end());
+  return *found;
+}
+
+void checkSeeGe(Board& board, int depth)
+{
+  for (const auto& move : board.generateMoves())
+  {
+    const int see = board.see(move);
+    for (int threshold = -10; threshold <= 10; ++threshold)
+    {
+      CHECK(board.seeGe(move, threshold) == (see >= threshold));
+    }
+
+    if (depth > 0)
+    {
+      board.makeMove(move);
+      checkSeeGe(board, depth - 1);
+      board.undoMove();
+    }
+  }
+}
+
+} // namespace
+
+TEST_CASE("Static exchange evaluation")
+{
+  SECTION("An undefended pawn is won")
+  {
+    Board board{ "1k1r4/1pp4p/p7/4p3/8/P5P1/1PP4P/2K1R3 w - - 0 1" };
+    CHECK(board.see(findMove(board, "e1", "e5")) == 1);
+  }
+
+  SECTION("A knight for a defended pawn loses")
+  {
+    Board board{ "1k1r3q/1ppn3p/p4b2/4p3/8/P2N2P1/1PP1R1BP/2K1Q3 w - - 0 1" };
+    CHECK(board.see(findMove(board, "d3", "e5")) == -2);
+  }
+
+  SECTION("Pieces behind the capturers join in")
+  {
+    // The second white rook recaptures through the first
+    Board board{ "3rk3/8/8/3p4/8/8/3R4/3RK3 w - - 0 1" };
+    CHECK(board.see(findMove(board, "d2", "d5")) == 1);
+
+    // The white queen behind the bishop stops the black queen recapturing
+    board.reset("4k3/8/5q2/4b3/8/8/1B6/4K3 w - - 0 1");
+    CHECK(board.see(findMove(board, "b2", "e5")) == 0);
+
+    board.reset("4k3/8/5q2/4b3/8/8/1B6/Q3K3 w - - 0 1");
+    CHECK(board.see(findMove(board, "b2", "e5")) == 3);
+  }
+
+  SECTION("The king only captures on undefended squares")
+  {
+    Board board{ "4k3/8/8/8/8/2q5/1P6/K7 b - - 0 1" };
+    CHECK(board.see(findMove(board, "c3", "b2")) == -7);
+
+    // Not once the bishop behind the queen defends it
+    board.reset("4k3/8/8/8/3b4/2q5/1P6/K7 b - - 0 1");
+    CHECK(board.see(findMove(board, "c3", "b2")) == 1);
+  }
+
+  SECTION("Quiet moves onto attacked squares")
+  {
+    Board board{ "4k3/8/8/4p3/8/8/8/3QK3 w - - 0 1" };
+    CHECK(board.see(findMove(board, "d1", "d4")) == -8);
+    CHECK(board.see(findMove(board, "d1", "d3")) == 0);
+  }
+
+  SECTION("En passant, promotions and castling")
+  {
+    Board board{ "4k3/8/8/3pP3/8/8/8/4K3 w - d6 0 1" };
+    CHECK(board.see(findMove(board, "e5", "d6")) == 1);
+
+    board.reset("r3k3/1P6/8/8/8/8/8/4K3 w - - 0 1");
+    CHECK(board.see(findMove(board, "b7", "b8", PieceType::QUEEN)) == -1);
+    CHECK(board.see(findMove(board, "b7", "a8", PieceType::QUEEN)) == 12);
+    CHECK(board.see(findMove(board, "b7", "a8", PieceType::KNIGHT)) == 7);
+
+    board.reset("r3k2r/8/8/8/8/8/8/R3K2R w KQkq - 0 1");
+    const auto moves = board.generateMoves();
+    const auto castle = findFirstCastlingMove(moves.begin(), moves.end());
+    REQUIRE(castle != moves.end());
+    CHECK(board.see(*castle) == 0);
+    CHECK(board.seeGe(*castle, 0));
+    CHECK_FALSE(board.seeGe(*castle, 1));
+  }
+
+  SECTION("seeGe agrees with see for every threshold")
+  {
+    Board board{ "r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq - 0 1" };
+    checkSeeGe(board, 1);
+
+    board.reset("r3k2r/Pppp1ppp/1b3nbN/nP6/BBP1P3/q4N2/Pp1P2PP/R2Q1RK1 w kq - 0 1");
+    checkSeeGe(board, 1);
+
+    board.reset("r4rk1/1pp1qppp/p1np1n2/2b1p1B1/2B1P1b1/P1NP1N2/1PP1QPPP/R4RK1 w - - 0 10");
+    checkSeeGe(board, 1);
+  }
+}
+
 } // namespace yak
@@ -2,42 +2,45 @@
 #include <MagicCommon.h>
 #include <types.h>
 
+#include <algorithm>
+#include <array>
+#include <cstdint>
+
 namespace yak {
 
-template<Square from, Square to>
-consteval Bitboard betweenSet()
+constexpr Bitboard betweenSet(Square from, Square to)
 {
-  constexpr Bitboard to_bb = bitboard::static_bitboard<to>::value;
+  const Bitboard to_bb = Bitboard{1} << to;
 
-  if (attackmap::Ray<Direction::NORTH, from>::value & to_bb)
+  if (attackmap::RayMap<Direction::NORTH>::value[from] & to_bb)
   {
     return attackmap::blockedRay<Direction::NORTH>(from, to_bb) ^ to_bb;
   }
-  else if (attackmap::Ray<Direction::NORTH_EAST, from>::value & to_bb)
+  else if (attackmap::RayMap<Direction::NORTH_EAST>::value[from] & to_bb)
   {
     return attackmap::blockedRay<Direction::NORTH_EAST>(from, to_bb) ^ to_bb;
   }
-  else if (attackmap::Ray<Direction::EAST, from>::value & to_bb)
+  else if (attackmap::RayMap<Direction::EAST>::value[from] & to_bb)
   {
     return attackmap::blockedRay<Direction::EAST>(from, to_bb) ^ to_bb;
   }
-  else if (attackmap::Ray<Direction::SOUTH_EAST, from>::value & to_bb)
+  else if (attackmap::RayMap<Direction::SOUTH_EAST>::value[from] & to_bb)
   {
     return attackmap::blockedRay<Direction::SOUTH_EAST>(from, to_bb) ^ to_bb;
   }
-  else if (attackmap::Ray<Direction::SOUTH, from>::value & to_bb)
+  else if (attackmap::RayMap<Direction::SOUTH>::value[from] & to_bb)
   {
     return attackmap::blockedRay<Direction::SOUTH>(from, to_bb) ^ to_bb;
   }
-  else if (attackmap::Ray<Direction::SOUTH_WEST, from>::value & to_bb)
+  else if (attackmap::RayMap<Direction::SOUTH_WEST>::value[from] & to_bb)
   {
     return attackmap::blockedRay<Direction::SOUTH_WEST>(from, to_bb) ^ to_bb;
   }
-  else if (attackmap::Ray<Direction::WEST, from>::value & to_bb)
+  else if (attackmap::RayMap<Direction::WEST>::value[from] & to_bb)
   {
     return attackmap::blockedRay<Direction::WEST>(from, to_bb) ^ to_bb;
   }
-  else if (attackmap::Ray<Direction::NORTH_WEST, from>::value & to_bb)
+  else if (attackmap::RayMap<Direction::NORTH_WEST>::value[from] & to_bb)
   {
     return attackmap::blockedRay<Direction::NORTH_WEST>(from, to_bb) ^ to_bb;
   }
@@ -45,33 +48,126 @@ consteval Bitboard betweenSet()
   return 0;
 }
 
-template<Square from, Square to, Bitboard... sets>
-struct OneSquareInBetween : OneSquareInBetween<from, static_cast<Square>(to + 1), sets..., betweenSet<from, to>()>
+template<Square from, Square to>
+consteval Bitboard betweenSet()
 {
-};
+  return betweenSet(from, to);
+}
 
-template<Square from, Bitboard... sets>
-struct OneSquareInBetween<from, H8, sets...>
+consteval auto buildInBetween() -> std::array<std::array<Bitboard, 64>, 64>
 {
-  static constexpr std::array<Bitboard, 64> value{ sets..., betweenSet<from, H8>() };
+  std::array<std::array<Bitboard, 64>, 64> table{};
+
+  for (int from = A1; from <= H8; ++from)
+  {
+    for (int to = A1; to <= H8; ++to)
+    {
+      table[from][to] = betweenSet(static_cast<Square>(from), static_cast<Square>(to));
+    }
+  }
+
+  return table;
+}
+
+/*
+ * Cache line aligned, so each from square's row of 64 bitboards occupies exactly 8 lines.
+ */
+struct InBetween
+{
+  alignas(64) static constexpr std::array<std::array<Bitboard, 64>, 64> value{ buildInBetween() };
 };
 
-template<Square S, std::array<Bitboard, 64>... arrays>
-struct InBetweenImpl : InBetweenImpl<static_cast<Square>(S + 1), arrays..., OneSquareInBetween<S, A1>::value>
+/*
+ * The full line (rank, file or diagonal) through two squares, from edge to edge of the board and
+ * including both squares, or an empty set if the squares are not on a common line.
+ */
+constexpr Bitboard lineThrough(Square from, Square to)
+{
+  const Bitboard from_bb = Bitboard{1} << from;
+  const Bitboard to_bb = Bitboard{1} << to;
+
+  constexpr auto line = [](Bitboard forward, Bitboard backward, Bitboard from_bb, Bitboard to_bb) -> Bitboard
+  {
+    return ((forward | backward) & to_bb) ? (forward | backward | from_bb) : 0;
+  };
+
+  if (from == to)
+  {
+    return 0;
+  }
+
+  return line(attackmap::RayMap<Direction::NORTH>::value[from], attackmap::RayMap<Direction::SOUTH>::value[from], from_bb, to_bb)
+       | line(attackmap::RayMap<Direction::EAST>::value[from], attackmap::RayMap<Direction::WEST>::value[from], from_bb, to_bb)
+       | line(attackmap::RayMap<Direction::NORTH_EAST>::value[from], attackmap::RayMap<Direction::SOUTH_WEST>::value[from], from_bb, to_bb)
+       | line(attackmap::RayMap<Direction::NORTH_WEST>::value[from], attackmap::RayMap<Direction::SOUTH_EAST>::value[from], from_bb, to_bb);
+}
+
+consteval auto buildLineThrough() -> std::array<std::array<Bitboard, 64>, 64>
+{
+  std::array<std::array<Bitboard, 64>, 64> table{};
+
+  for (int from = A1; from <= H8; ++from)
+  {
+    for (int to = A1; to <= H8; ++to)
+    {
+      table[from][to] = lineThrough(static_cast<Square>(from), static_cast<Square>(to));
+    }
+  }
+
+  return table;
+}
+
+/*
+ * A piece pinned against its king can only move along LineThrough::value[king][pinned], and a
+ * piece moving off that line uncovers any slider behind it.
+ */
+struct LineThrough
 {
+  alignas(64) static constexpr std::array<std::array<Bitboard, 64>, 64> value{ buildLineThrough() };
 };
 
-template<std::array<Bitboard, 64>... arrays>
-struct InBetweenImpl<H8, arrays...>
+/*
+ * Distance tables, indexed like InBetween. Chebyshev distance is the number of king moves between
+ * two squares, Manhattan distance the number of rook steps.
+ */
+consteval auto buildDistance(bool manhattan) -> std::array<std::array<uint8_t, 64>, 64>
 {
-  static constexpr std::array<std::array<Bitboard, 64>, 64> value{ arrays... };
+  std::array<std::array<uint8_t, 64>, 64> table{};
+
+  for (int from = A1; from <= H8; ++from)
+  {
+    for (int to = A1; to <= H8; ++to)
+    {
+      const int files = (from & 7) > (to & 7) ? (from & 7) - (to & 7) : (to & 7) - (from & 7);
+      const int ranks = (from >> 3) > (to >> 3) ? (from >> 3) - (to >> 3) : (to >> 3) - (from >> 3);
+
+      table[from][to] = static_cast<uint8_t>(manhattan ? files + ranks : std::max(files, ranks));
+    }
+  }
+
+  return table;
+}
+
+struct ChebyshevDistance
+{
+  alignas(64) static constexpr std::array<std::array<uint8_t, 64>, 64> value{ buildDistance(false) };
 };
 
-struct InBetween
+struct ManhattanDistance
 {
-  static constexpr std::array<std::array<Bitboard, 64>, 64> value{ InBetweenImpl<A1>::value };
+  alignas(64) static constexpr std::array<std::array<uint8_t, 64>, 64> value{ buildDistance(true) };
 };
 
+constexpr int distance(Square from, Square to)
+{
+  return ChebyshevDistance::value[from][to];
+}
+
+constexpr int manhattanDistance(Square from, Square to)
+{
+  return ManhattanDistance::value[from][to];
+}
+
 template<PieceType Type>
 constexpr Bitboard xRayAttacks(Bitboard occupied_bb, Bitboard blocker_bb, Square piece)
 {
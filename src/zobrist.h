@@ -0,0 +1,103 @@
+#ifndef YAK_ZOBRIST_H_
+#define YAK_ZOBRIST_H_
+
+#include "types.h"
+
+#include <array>
+#include <cstdint>
+
+namespace yak::zobrist {
+
+using Key = uint64_t;
+
+/*
+ * Zobrist keys, generated at compile time with splitmix64 from a fixed seed so that hashes are the
+ * same in every build (and can be compared between runs).
+ *
+ * A position's hash is the XOR of the keys of every piece on its square, the castling rights, the
+ * en passant file (whenever an ep square is set) and, if black is to move, SIDE.
+ */
+struct Keys
+{
+  std::array<std::array<std::array<Key, 64>, 6>, 2> m_pieces{};
+  std::array<Key, 16> m_castling{};
+  std::array<Key, 8> m_epFile{};
+  Key m_side{ 0 };
+};
+
+consteval auto buildKeys() -> Keys
+{
+  uint64_t state{ 0x59414b5a4f425249ULL };
+
+  auto next = [&state]
+  {
+    state += 0x9e3779b97f4a7c15ULL;
+    uint64_t z = state;
+    z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+    z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+    return z ^ (z >> 31);
+  };
+
+  Keys keys{};
+
+  for (auto& colour : keys.m_pieces)
+  {
+    for (auto& piece : colour)
+    {
+      for (auto& square : piece)
+      {
+        square = next();
+      }
+    }
+  }
+
+  // Each castling right has its own key, and the key of a set of rights is the XOR of its members,
+  // so that a change of rights can be applied with a single XOR.
+  std::array<Key, 4> rights{ next(), next(), next(), next() };
+  for (int mask = 0; mask < 16; ++mask)
+  {
+    for (int right = 0; right < 4; ++right)
+    {
+      if (mask & (1 << right)) keys.m_castling[mask] ^= rights[right];
+    }
+  }
+
+  for (auto& file : keys.m_epFile)
+  {
+    file = next();
+  }
+
+  keys.m_side = next();
+
+  return keys;
+}
+
+inline constexpr Keys KEYS{ buildKeys() };
+
+constexpr auto piece(PieceColour colour, PieceType type, Square square) -> Key
+{
+  return KEYS.m_pieces[static_cast<int>(colour)][static_cast<int>(type)][square];
+}
+
+/*
+ * \param[in] rights - Castling rights as a 4 bit mask, in the order black king side, black queen
+ *                     side, white king side, white queen side (see GameState::castlingRights).
+ */
+constexpr auto castling(int rights) -> Key
+{
+  return KEYS.m_castling[rights];
+}
+
+constexpr auto enPassant(Square square) -> Key
+{
+  return (square == NULL_SQUARE) ? 0 : KEYS.m_epFile[square & 7];
+}
+
+constexpr auto side(PieceColour colour) -> Key
+{
+  return (colour == PieceColour::BLACK) ? KEYS.m_side : 0;
+}
+
+} // namespace yak::zobrist
+
+#endif // YAK_ZOBRIST_H_